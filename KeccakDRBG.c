@@ -0,0 +1,133 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "KeccakSponge.h"
+#include "KeccakErase.h"
+#include "KeccakSP800185.h"
+#include "KeccakDRBG.h"
+
+/**
+  * Start a new sponge on encode_string(key) || encode_string(extra).
+  */
+static void Rekey(KeccakDRBG * drbg, const uint8_t * key, uint64_t keyByteLen,
+                  const uint8_t * extra, uint64_t extraByteLen)
+{
+    static const uint8_t customization[] = "KeccakDRBG";
+    uint8_t encoding[9];
+    uint32_t encodingLength;
+
+    InitcSHAKE(&drbg->sponge, drbg->securityStrength, NULL, 0, customization, sizeof(customization) - 1);
+
+    encodingLength = SP800185LeftEncode(encoding, keyByteLen * 8);
+    AbsorbBytes(&drbg->sponge, encoding, encodingLength);
+    AbsorbBytes(&drbg->sponge, key, keyByteLen);
+
+    encodingLength = SP800185LeftEncode(encoding, extraByteLen * 8);
+    AbsorbBytes(&drbg->sponge, encoding, encodingLength);
+    AbsorbBytes(&drbg->sponge, extra, extraByteLen);
+}
+
+/**
+  * Replace the sponge by one seeded from its next output, with @a extra mixed in.
+  */
+static void Ratchet(KeccakDRBG * drbg, const uint8_t * extra, uint64_t extraByteLen)
+{
+    uint8_t key[KeccakDRBGKeyByteLen];
+
+    Squeeze(&drbg->sponge, key, sizeof(key) * 8);
+    Rekey(drbg, key, sizeof(key), extra, extraByteLen);
+
+    KeccakSecureErase(key, sizeof(key)); // Clear memory of secret data
+}
+
+SpongeReturn KeccakDRBGInstantiate(KeccakDRBG * drbg, uint32_t securityStrength,
+                                   const uint8_t * seed, uint64_t seedByteLen,
+                                   const uint8_t * personalization, uint64_t personalizationByteLen)
+{
+    if ((securityStrength != 128) && (securityStrength != 256)) {
+        return BAD_RATE_CAPACITY;
+    }
+
+    drbg->securityStrength = securityStrength;
+    drbg->bufferPosition = KeccakDRBGBufferByteLen;
+
+    Rekey(drbg, seed, seedByteLen, personalization, personalizationByteLen);
+
+    return SUCCESS;
+}
+
+SpongeReturn KeccakDRBGInstantiateFromSystem(KeccakDRBG * drbg, uint32_t securityStrength,
+                                             const uint8_t * personalization, uint64_t personalizationByteLen)
+{
+    uint8_t seed[KeccakDRBGKeyByteLen];
+    SpongeReturn returnVal;
+    FILE * urandom = fopen("/dev/urandom", "rb");
+
+    if (urandom == NULL) {
+        return FAIL;
+    }
+
+    size_t seedByteLen = fread(seed, 1, sizeof(seed), urandom);
+    fclose(urandom);
+
+    if (seedByteLen != sizeof(seed)) {
+        returnVal = FAIL;
+    }
+    else {
+        returnVal = KeccakDRBGInstantiate(drbg, securityStrength, seed, sizeof(seed),
+                                          personalization, personalizationByteLen);
+    }
+
+    KeccakSecureErase(seed, sizeof(seed)); // Clear memory of secret data
+
+    return returnVal;
+}
+
+void KeccakDRBGReseed(KeccakDRBG * drbg, const uint8_t * entropy, uint64_t entropyByteLen)
+{
+    memset(drbg->buffer + drbg->bufferPosition, 0, KeccakDRBGBufferByteLen - drbg->bufferPosition);
+    drbg->bufferPosition = KeccakDRBGBufferByteLen;
+
+    Ratchet(drbg, entropy, entropyByteLen);
+}
+
+void KeccakDRBGGenerate(KeccakDRBG * drbg, uint8_t * output, uint64_t outputByteLen)
+{
+    while(outputByteLen > 0) {
+        uint32_t available = KeccakDRBGBufferByteLen - drbg->bufferPosition;
+
+        if (available == 0) {
+            if (outputByteLen >= KeccakDRBGBufferByteLen) {
+                // Large requests bypass the buffer
+                Squeeze(&drbg->sponge, output, outputByteLen * 8);
+                Ratchet(drbg, NULL, 0);
+                return;
+            }
+
+            Squeeze(&drbg->sponge, drbg->buffer, KeccakDRBGBufferByteLen * 8);
+            Ratchet(drbg, NULL, 0);
+            drbg->bufferPosition = 0;
+            available = KeccakDRBGBufferByteLen;
+        }
+
+        uint32_t length = (outputByteLen < available) ? (uint32_t) outputByteLen : available;
+
+        memcpy(output, drbg->buffer + drbg->bufferPosition, length);
+        memset(drbg->buffer + drbg->bufferPosition, 0, length); // Handed out bytes are not kept
+        drbg->bufferPosition += length;
+        output += length;
+        outputByteLen -= length;
+    }
+}
+
+void KeccakDRBGErase(KeccakDRBG * drbg)
+{
+    KeccakSecureErase(drbg, sizeof(KeccakDRBG));
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+
+/*
+ * A deterministic random bit generator on cSHAKE
+ *
+ * The generator is a cSHAKE sponge (S = "KeccakDRBG") in the squeezing phase.
+ * Output is squeezed KeccakDRBGBufferByteLen bytes at a time into an internal
+ * buffer, so small requests are copies from the buffer; requests of a whole
+ * buffer or more are squeezed straight into the caller's memory.
+ *
+ * After every squeeze the sponge is ratcheted: 64 bytes of output become the
+ * seed of a fresh sponge and are erased, and buffered bytes are erased as they
+ * are handed out. Capturing the generator therefore reveals nothing about the
+ * output it produced before.
+ *
+ * Rekeying with a key K and extra input E starts a new sponge on
+ * encode_string(K) || encode_string(E):
+ *   instantiate:   K = seed,           E = personalization string
+ *   ratchet:       K = 64 output bytes, E = ""
+ *   reseed:        K = 64 output bytes, E = entropy input
+ *
+ * A generator is not thread-safe; give each thread its own instance.
+ */
+
+#define KeccakDRBGBufferByteLen 8192
+#define KeccakDRBGKeyByteLen 64
+
+typedef struct {
+    SpongeState sponge;
+
+    uint8_t buffer[KeccakDRBGBufferByteLen];
+    uint32_t bufferPosition;        // Bytes before it are handed out and erased
+
+    uint32_t securityStrength;
+} KeccakDRBG;
+
+/**
+  * Seed a generator.
+  * @param  drbg        Pointer to the generator.
+  * @param  securityStrength    128 or 256.
+  * @param  seed        Pointer to the seed, which should hold at least securityStrength bits of entropy.
+  * @param  seedByteLen The number of bytes in the seed.
+  * @param  personalization     Pointer to a personalization string, e.g. a thread identifier.
+  * @param  personalizationByteLen  The number of bytes in the personalization string, may be 0.
+  * @return SpongeReturn
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         SUCCESS           - Generator seeded
+  */
+SpongeReturn KeccakDRBGInstantiate(KeccakDRBG * drbg, uint32_t securityStrength,
+                                   const uint8_t * seed, uint64_t seedByteLen,
+                                   const uint8_t * personalization, uint64_t personalizationByteLen);
+
+/**
+  * Seed a generator from /dev/urandom.
+  * @param  drbg        Pointer to the generator.
+  * @param  securityStrength    128 or 256.
+  * @param  personalization     Pointer to a personalization string, e.g. a thread identifier.
+  * @param  personalizationByteLen  The number of bytes in the personalization string, may be 0.
+  * @return SpongeReturn
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         FAIL              - /dev/urandom could not be read.
+  *         SUCCESS           - Generator seeded
+  */
+SpongeReturn KeccakDRBGInstantiateFromSystem(KeccakDRBG * drbg, uint32_t securityStrength,
+                                             const uint8_t * personalization, uint64_t personalizationByteLen);
+
+/**
+  * Mix fresh entropy into a generator. Buffered output is discarded.
+  * @param  drbg        Pointer to the generator.
+  * @param  entropy     Pointer to the entropy input.
+  * @param  entropyByteLen  The number of bytes of entropy input.
+  */
+void KeccakDRBGReseed(KeccakDRBG * drbg, const uint8_t * entropy, uint64_t entropyByteLen);
+
+/**
+  * Get random bytes.
+  * @param  drbg        Pointer to the generator.
+  * @param  output      Pointer to the buffer where to store the random bytes.
+  * @param  outputByteLen   The number of random bytes.
+  */
+void KeccakDRBGGenerate(KeccakDRBG * drbg, uint8_t * output, uint64_t outputByteLen);
+
+/**
+  * Erase a generator.
+  * @param  drbg        Pointer to the generator.
+  */
+void KeccakDRBGErase(KeccakDRBG * drbg);
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+
+/*
+ * Wire protocol of keccakd, the local hashing daemon
+ *
+ * Clients connect to a SOCK_SEQPACKET Unix domain socket, so every request and
+ * every response is one packet. A request is a KeccakDaemonRequest followed by
+ * the message, or, with KeccakDaemonRequestFile set, by nothing: the message is
+ * then the whole content of the regular file whose descriptor is passed with
+ * the packet as SCM_RIGHTS ancillary data. A memfd sealed with F_SEAL_SHRINK
+ * is mapped by the daemon, any other file is read. The daemon answers the
+ * requests of a connection in order, each with a KeccakDaemonResponse followed
+ * by outputByteLen bytes of output when the status is 0. A client that leaves
+ * responses unread for a second is disconnected.
+ *
+ * All fields are in the byte order of the host; the socket never leaves it.
+ */
+
+#define KeccakDaemonDefaultSocket "/tmp/keccakd.sock"
+
+// Largest message sent in the packet itself, larger ones are passed as a file
+#define KeccakDaemonMaxInlineByteLen (64 * 1024)
+
+// Largest output of a request
+#define KeccakDaemonMaxOutputByteLen 4096
+
+// The message is the file descriptor passed with the request
+#define KeccakDaemonRequestFile 0x01
+
+typedef enum {
+    KeccakDaemonSHA3_224,
+    KeccakDaemonSHA3_256,
+    KeccakDaemonSHA3_384,
+    KeccakDaemonSHA3_512,
+    KeccakDaemonKeccak224,
+    KeccakDaemonKeccak256,
+    KeccakDaemonKeccak384,
+    KeccakDaemonKeccak512,
+    KeccakDaemonSHAKE128,
+    KeccakDaemonSHAKE256,
+    KeccakDaemonNrAlgorithms,
+} KeccakDaemonAlgorithm;
+
+typedef struct {
+    uint32_t id;                // Copied to the response
+    uint8_t algorithm;          // A KeccakDaemonAlgorithm
+    uint8_t flags;              // KeccakDaemonRequestFile or 0
+    uint16_t reserved;          // 0
+    uint32_t outputByteLen;     // Any length up to the maximum for SHAKE, the digest length otherwise
+} KeccakDaemonRequest;
+
+typedef struct {
+    uint32_t id;
+    int32_t status;             // 0, or an errno value: EINVAL (also for a descriptor that is not a regular
+                                // file), EMSGSIZE, EBADF (no descriptor, or more than one) or the error
+                                // reading the file
+    uint32_t outputByteLen;
+} KeccakDaemonResponse;
+
+typedef struct {
+    const char * name;
+    uint32_t capacity;
+    uint8_t delimitedSuffix;
+    uint32_t outputByteLen;     // Length of the digest, 0 for extendable output
+} KeccakDaemonAlgorithmParameters;
+
+static const KeccakDaemonAlgorithmParameters KeccakDaemonAlgorithms[KeccakDaemonNrAlgorithms] = {
+    {"sha3-224",   448,  SHA3DelimitedSuffix,   28},
+    {"sha3-256",   512,  SHA3DelimitedSuffix,   32},
+    {"sha3-384",   768,  SHA3DelimitedSuffix,   48},
+    {"sha3-512",   1024, SHA3DelimitedSuffix,   64},
+    {"keccak-224", 448,  KeccakDelimitedSuffix, 28},
+    {"keccak-256", 512,  KeccakDelimitedSuffix, 32},
+    {"keccak-384", 768,  KeccakDelimitedSuffix, 48},
+    {"keccak-512", 1024, KeccakDelimitedSuffix, 64},
+    {"shake128",   256,  SHAKEDelimitedSuffix,  0},
+    {"shake256",   512,  SHAKEDelimitedSuffix,  0},
+};
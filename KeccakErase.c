@@ -0,0 +1,40 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "KeccakErase.h"
+
+#if defined(__GNUC__)
+
+void KeccakSecureErase(void * data, size_t length)
+{
+    memset(data, 0, length);
+
+    // The compiler must assume the cleared memory is read here, so the memset is kept
+    __asm__ __volatile__("" : : "r"(data) : "memory");
+}
+
+#else
+
+void KeccakSecureErase(void * data, size_t length)
+{
+    volatile uint8_t * bytes = (volatile uint8_t *) data;
+
+    while(length > 0) {
+        *bytes++ = 0;
+        length--;
+    }
+}
+
+#endif
+
+void KeccakSecureEraseStack(void)
+{
+    uint8_t stack[KeccakEraseStackByteLen];
+
+    KeccakSecureErase(stack, sizeof(stack));
+}
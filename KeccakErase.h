@@ -0,0 +1,68 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Erasure of secret data
+ *
+ * KECCAK_ERASE_POLICY selects, at build time, when memory that held input or
+ * state is cleared:
+ *   KECCAK_ERASE_STRICT    (default) Contexts, scratch states and buffers are
+ *                          cleared once per operation, when a one-shot function
+ *                          returns or by EraseState(). Round temporaries that
+ *                          live on the stack, such as the C, D and tempA arrays
+ *                          of the reference permutation, are not cleared per
+ *                          step; KeccakEraseStack() clears that stack at the
+ *                          same point.
+ *   KECCAK_ERASE_STEPS     As strict, and each round step of the reference
+ *                          permutation also clears its own temporaries.
+ *   KECCAK_ERASE_NONE      Nothing is cleared. Only for programs hashing public
+ *                          data. Keys are still erased by the one-shot KMAC(),
+ *                          KMACFromKeyState(), the DRBG and SpongeWrap; a KMAC
+ *                          key state must be wiped with EraseKMAC(), as
+ *                          EraseState() clears nothing in this mode.
+ * Erasures go through KeccakSecureErase(), which the compiler cannot remove as
+ * a dead store.
+ */
+
+#define KECCAK_ERASE_NONE   0
+#define KECCAK_ERASE_STRICT 1
+#define KECCAK_ERASE_STEPS  2
+
+#if !defined(KECCAK_ERASE_POLICY)
+#define KECCAK_ERASE_POLICY KECCAK_ERASE_STRICT
+#endif
+
+// Bytes of stack cleared below the caller by KeccakSecureEraseStack()
+#define KeccakEraseStackByteLen 2048
+
+/**
+  * Clear memory, whatever the erasure policy, in a way the compiler cannot remove.
+  * @param  data        Pointer to the memory.
+  * @param  length      The number of bytes to clear.
+  */
+void KeccakSecureErase(void * data, size_t length);
+
+/**
+  * Clear KeccakEraseStackByteLen bytes of the stack below the caller, where the
+  * permutation and the sponge functions it called kept their temporaries.
+  */
+void KeccakSecureEraseStack(void);
+
+#if KECCAK_ERASE_POLICY >= KECCAK_ERASE_STRICT
+#define KeccakErase(data, length) KeccakSecureErase((data), (length))
+#define KeccakEraseStack() KeccakSecureEraseStack()
+#else
+#define KeccakErase(data, length) ((void) (data), (void) (length))
+#define KeccakEraseStack()
+#endif
+
+#if KECCAK_ERASE_POLICY >= KECCAK_ERASE_STEPS
+#define KeccakEraseStep(data, length) KeccakSecureErase((data), (length))
+#else
+#define KeccakEraseStep(data, length) ((void) (data), (void) (length))
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "KeccakSponge.h"
+#include "KeccakF-1600-times.h"
+
+#if defined(KECCAK_X86)
+
+#include <immintrin.h>
+
+/*
+ * Four states in lock-step: lane i of state s is element s of vector i.
+ * The functions are compiled for AVX2 on their own, so the rest of the
+ * library still runs on CPUs without it.
+ */
+#define KECCAK_AVX2 __attribute__((target("avx2")))
+
+typedef __m256i V256;
+
+#define XOR(a, b)               _mm256_xor_si256(a, b)
+#define XOR5(a, b, c, d, e)     XOR(XOR(XOR(a, b), XOR(c, d)), e)
+#define ROL(a, offset)          _mm256_or_si256(_mm256_slli_epi64(a, offset), _mm256_srli_epi64(a, 64 - (offset)))
+#define ANDNXOR(a, b, c)        _mm256_xor_si256(a, _mm256_andnot_si256(b, c))
+#define CONST64(c)              _mm256_set1_epi64x((long long) (c))
+
+#include "KeccakF-1600-simd.macros"
+
+// x86 is little-endian, so a lane of input data can be loaded directly
+static uint64_t loadDataLane(const uint8_t * const data[4], uint32_t s, uint32_t lane, uint32_t laneCount)
+{
+    uint64_t value = 0;
+    if (lane < laneCount) {
+        memcpy(&value, data[s] + 8 * lane, 8);
+    }
+    return value;
+}
+
+#define loadLane(name, i) \
+    A##name = _mm256_set_epi64x((long long) (SpongeLane(states[3], i) ^ loadDataLane(data, 3, i, laneCount)), \
+                                (long long) (SpongeLane(states[2], i) ^ loadDataLane(data, 2, i, laneCount)), \
+                                (long long) (SpongeLane(states[1], i) ^ loadDataLane(data, 1, i, laneCount)), \
+                                (long long) (SpongeLane(states[0], i) ^ loadDataLane(data, 0, i, laneCount)));
+
+#define storeLane(name, i) \
+    _mm256_storeu_si256((V256 *) lanes, A##name); \
+    SpongeLane(states[0], i) = lanes[0]; \
+    SpongeLane(states[1], i) = lanes[1]; \
+    SpongeLane(states[2], i) = lanes[2]; \
+    SpongeLane(states[3], i) = lanes[3];
+
+/**
+  * XOR laneCount lanes of data into each state, then run the last roundCount rounds.
+  */
+static KECCAK_AVX2 void PermuteTimes4(SpongeMatrix states[4], const uint8_t * const data[4], uint32_t laneCount,
+                                     uint32_t roundCount)
+{
+    declareLanes(V256, A)
+    declareLanes(V256, B)
+    declareLanes(V256, E)
+    V256 Ca, Ce, Ci, Co, Cu;
+    V256 Da, De, Di, Do, Du;
+    uint64_t lanes[4];
+    uint32_t round;
+
+    forEachLane(loadLane)
+
+    rounds(24 - roundCount, A, E)
+
+    forEachLane(storeLane)
+}
+
+void KeccakPermutationTimes4AVX2(SpongeMatrix states[4], uint32_t rounds)
+{
+    PermuteTimes4(states, NULL, 0, rounds);
+}
+
+void KeccakAbsorbTimes4AVX2(SpongeMatrix states[4], const uint8_t * const data[4], uint32_t rate, uint32_t rounds)
+{
+    PermuteTimes4(states, data, rate/64, rounds);
+}
+
+#endif
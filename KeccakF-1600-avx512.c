@@ -0,0 +1,91 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "KeccakSponge.h"
+#include "KeccakF-1600-times.h"
+
+#if defined(KECCAK_X86)
+
+#include <immintrin.h>
+
+/*
+ * Eight states in lock-step: lane i of state s is element s of vector i.
+ * AVX-512 has a native rotate, and vpternlogq computes the three-input
+ * XOR of theta and the whole chi step in one instruction each.
+ */
+#define KECCAK_AVX512 __attribute__((target("avx512f")))
+
+typedef __m512i V512;
+
+#define XOR(a, b)               _mm512_xor_si512(a, b)
+#define XOR3(a, b, c)           _mm512_ternarylogic_epi64(a, b, c, 0x96)
+#define XOR5(a, b, c, d, e)     XOR3(XOR3(a, b, c), d, e)
+#define ROL(a, offset)          _mm512_rol_epi64(a, offset)
+#define ANDNXOR(a, b, c)        _mm512_ternarylogic_epi64(a, b, c, 0xD2)
+#define CONST64(c)              _mm512_set1_epi64((long long) (c))
+
+#include "KeccakF-1600-simd.macros"
+
+// x86 is little-endian, so a lane of input data can be loaded directly
+static uint64_t loadDataLane(const uint8_t * const data[8], uint32_t s, uint32_t lane, uint32_t laneCount)
+{
+    uint64_t value = 0;
+    if (lane < laneCount) {
+        memcpy(&value, data[s] + 8 * lane, 8);
+    }
+    return value;
+}
+
+#define stateLane(s, i) (long long) (SpongeLane(states[s], i) ^ loadDataLane(data, s, i, laneCount))
+
+#define loadLane(name, i) \
+    A##name = _mm512_set_epi64(stateLane(7, i), stateLane(6, i), stateLane(5, i), stateLane(4, i), \
+                               stateLane(3, i), stateLane(2, i), stateLane(1, i), stateLane(0, i));
+
+#define storeLane(name, i) \
+    _mm512_storeu_si512((void *) lanes, A##name); \
+    SpongeLane(states[0], i) = lanes[0]; \
+    SpongeLane(states[1], i) = lanes[1]; \
+    SpongeLane(states[2], i) = lanes[2]; \
+    SpongeLane(states[3], i) = lanes[3]; \
+    SpongeLane(states[4], i) = lanes[4]; \
+    SpongeLane(states[5], i) = lanes[5]; \
+    SpongeLane(states[6], i) = lanes[6]; \
+    SpongeLane(states[7], i) = lanes[7];
+
+/**
+  * XOR laneCount lanes of data into each state, then run the last roundCount rounds.
+  */
+static KECCAK_AVX512 void PermuteTimes8(SpongeMatrix states[8], const uint8_t * const data[8], uint32_t laneCount,
+                                       uint32_t roundCount)
+{
+    declareLanes(V512, A)
+    declareLanes(V512, B)
+    declareLanes(V512, E)
+    V512 Ca, Ce, Ci, Co, Cu;
+    V512 Da, De, Di, Do, Du;
+    uint64_t lanes[8];
+    uint32_t round;
+
+    forEachLane(loadLane)
+
+    rounds(24 - roundCount, A, E)
+
+    forEachLane(storeLane)
+}
+
+void KeccakPermutationTimes8AVX512(SpongeMatrix states[8], uint32_t rounds)
+{
+    PermuteTimes8(states, NULL, 0, rounds);
+}
+
+void KeccakAbsorbTimes8AVX512(SpongeMatrix states[8], const uint8_t * const data[8], uint32_t rate, uint32_t rounds)
+{
+    PermuteTimes8(states, data, rate/64, rounds);
+}
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "KeccakSponge.h"
+#include "KeccakF-1600-reference.h"
+#include "KeccakF-1600-opt64.h"
+#include "KeccakF-1600-times.h"
+#include "KeccakF-1600-dispatch.h"
+#include "KeccakInstrumentation.h"
+
+/*
+ * CPU feature checks
+ *
+ * __builtin_cpu_supports reads the CPUID results that the runtime collects at
+ * startup and also checks that the OS saves the vector registers.
+ */
+static int32_t AlwaysSupported(void)
+{
+    return 1;
+}
+
+#if defined(KECCAK_X86)
+static int32_t HasBMI2(void)
+{
+    return __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2");
+}
+
+static int32_t HasAVX2(void)
+{
+    return HasBMI2() && __builtin_cpu_supports("avx2");
+}
+
+static int32_t HasAVX512(void)
+{
+    return HasAVX2() && __builtin_cpu_supports("avx512f");
+}
+#endif
+
+/*
+ * Backend table, from slowest to fastest
+ */
+static const KeccakBackend KeccakBackends[] = {
+    {"reference", AlwaysSupported, KeccakPermutationReference, KeccakPermutationRoundsReference,
+                  NULL, NULL, NULL, NULL},
+    {"opt64",     AlwaysSupported, KeccakPermutationOpt64,     KeccakPermutationRoundsOpt64,
+                  NULL, NULL, NULL, NULL},
+#if defined(KECCAK_X86)
+    {"bmi2",      HasBMI2,         KeccakPermutationOpt64BMI2, KeccakPermutationRoundsOpt64BMI2,
+                  NULL, NULL, NULL, NULL},
+    {"avx2",      HasAVX2,         KeccakPermutationOpt64BMI2, KeccakPermutationRoundsOpt64BMI2,
+                  KeccakPermutationTimes4AVX2, KeccakAbsorbTimes4AVX2, NULL, NULL},
+    {"avx512",    HasAVX512,       KeccakPermutationOpt64BMI2, KeccakPermutationRoundsOpt64BMI2,
+                  KeccakPermutationTimes4AVX2, KeccakAbsorbTimes4AVX2,
+                  KeccakPermutationTimes8AVX512, KeccakAbsorbTimes8AVX512},
+#endif
+};
+
+#define nrBackends (sizeof(KeccakBackends) / sizeof(KeccakBackends[0]))
+
+/*
+ * The active backend may be switched by KeccakSelectBackend() while other threads
+ * hash, so the pointer is only accessed atomically. Any backend gives the same
+ * results, so a thread seeing the old one for a moment is harmless.
+ */
+static const KeccakBackend * activeBackend = NULL;
+static pthread_once_t defaultBackendOnce = PTHREAD_ONCE_INIT;
+
+#if defined(__GNUC__)
+#define LoadActiveBackend() __atomic_load_n(&activeBackend, __ATOMIC_ACQUIRE)
+#define StoreActiveBackend(backend) __atomic_store_n(&activeBackend, (backend), __ATOMIC_RELEASE)
+#else
+#define LoadActiveBackend() (activeBackend)
+#define StoreActiveBackend(backend) (activeBackend = (backend))
+#endif
+
+static const KeccakBackend * FindBackend(const char * name)
+{
+    uint32_t i;
+    for(i = 0; i < nrBackends; i++) {
+        if ((strcmp(KeccakBackends[i].name, name) == 0) && KeccakBackends[i].isSupported()) {
+            return &KeccakBackends[i];
+        }
+    }
+    return NULL;
+}
+
+static void SelectDefaultBackend(void)
+{
+    const char * forced = getenv("KECCAK_BACKEND");
+    const KeccakBackend * backend = NULL;
+
+    if (forced != NULL) {
+        backend = FindBackend(forced);
+    }
+
+    // Pick the last (fastest) supported backend; the reference is only used when forced
+    if (backend == NULL) {
+        uint32_t i;
+        for(i = 1; i < nrBackends; i++) {
+            if (KeccakBackends[i].isSupported()) {
+                backend = &KeccakBackends[i];
+            }
+        }
+    }
+
+    StoreActiveBackend(backend);
+}
+
+const KeccakBackend * KeccakGetBackend(void)
+{
+    pthread_once(&defaultBackendOnce, SelectDefaultBackend);
+    return LoadActiveBackend();
+}
+
+SpongeReturn KeccakSelectBackend(const char * name)
+{
+    const KeccakBackend * backend = FindBackend(name);
+
+    if (backend == NULL) {
+        return FAIL;
+    }
+
+    // Make sure the default selection cannot run later and override this choice
+    pthread_once(&defaultBackendOnce, SelectDefaultBackend);
+    StoreActiveBackend(backend);
+
+    return SUCCESS;
+}
+
+const KeccakBackend * KeccakListBackends(uint32_t * count)
+{
+    *count = nrBackends;
+    return KeccakBackends;
+}
+
+/*
+ * Dispatched entry points
+ */
+void KeccakPermutation(SpongeMatrix state)
+{
+    KeccakTimerStart(start);
+
+    KeccakGetBackend()->permutation(state);
+
+    KeccakCount(permutations, 1);
+    KeccakTimerStop(permutationNanoseconds, start);
+}
+
+void KeccakPermutationRounds(SpongeMatrix state, uint32_t rounds)
+{
+    const KeccakBackend * backend = KeccakGetBackend();
+    KeccakTimerStart(start);
+
+    // The full permutation keeps its fully unrolled code
+    if (rounds == nrRounds) {
+        backend->permutation(state);
+    } else {
+        backend->permutationRounds(state, rounds);
+    }
+
+    KeccakCount(permutations, 1);
+    KeccakTimerStop(permutationNanoseconds, start);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include "KeccakSponge.h"
+
+/*
+ * Permutation backend dispatch
+ *
+ * KeccakPermutation() and the multi-state functions in KeccakF-1600-times.h
+ * call through the active backend. On first use the fastest backend the host
+ * supports is selected, in the order avx512, avx2, bmi2, opt64. Setting the
+ * environment variable KECCAK_BACKEND to a backend name, or calling
+ * KeccakSelectBackend(), forces a particular backend, e.g. for testing.
+ */
+
+typedef struct {
+    const char * name;
+
+    // Returns 1 if the host CPU can run this backend
+    int32_t (*isSupported)(void);
+
+    void (*permutation)(SpongeMatrix state);
+
+    // Keccak-p[1600, rounds], the last rounds of the schedule
+    void (*permutationRounds)(SpongeMatrix state, uint32_t rounds);
+
+    // Multi-state functions taking the number of rounds, NULL when the backend runs the states one at a time
+    void (*permutationTimes4)(SpongeMatrix states[4], uint32_t rounds);
+    void (*absorbTimes4)(SpongeMatrix states[4], const uint8_t * const data[4], uint32_t rate, uint32_t rounds);
+    void (*permutationTimes8)(SpongeMatrix states[8], uint32_t rounds);
+    void (*absorbTimes8)(SpongeMatrix states[8], const uint8_t * const data[8], uint32_t rate, uint32_t rounds);
+} KeccakBackend;
+
+/**
+  * Get the active permutation backend, selecting the default one on first use.
+  * @return Pointer to the active backend.
+  */
+const KeccakBackend * KeccakGetBackend(void);
+
+/**
+  * Force the permutation backend.
+  * It may be called at any time, even while other threads hash: the active
+  * backend is switched atomically, and a permutation already running finishes
+  * on the backend it started with. All backends give the same results.
+  * @param  name        Name of the backend: reference, opt64, bmi2, avx2 or avx512.
+  * @return SpongeReturn
+  *         FAIL        - The backend is unknown or not supported by the host CPU.
+  *         SUCCESS     - The backend is now active.
+  */
+SpongeReturn KeccakSelectBackend(const char * name);
+
+/**
+  * Get the table of all backends compiled into the library,
+  * including those the host CPU does not support.
+  * @param  count       Pointer to where to store the number of backends.
+  * @return Pointer to the first backend of the table.
+  */
+const KeccakBackend * KeccakListBackends(uint32_t * count);
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+#include "KeccakF-1600-opt64.h"
+
+/*
+ * Lane naming
+ *
+ * Each lane of the state is held in its own local variable. The first letter
+ * after the prefix is the row y (b, g, k, m, s for y = 0..4) and the second
+ * letter is the column x (a, e, i, o, u for x = 0..4), so Ake is A[1][2].
+ */
+
+#define ROL64(a, offset) ((((uint64_t) (a)) << (offset)) ^ (((uint64_t) (a)) >> (64 - (offset))))
+
+static const uint64_t KeccakRoundConstantsOpt64[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL,
+    0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL,
+    0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL,
+    0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL,
+    0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+
+/*
+ * One round of KeccakF reading the lanes A##xx and writing the lanes E##xx.
+ *
+ * Theta is folded into the lane loads, rho and pi are folded into the choice
+ * of input lane and rotation for each B, and chi and iota produce E directly.
+ *
+ * The lanes Abe, Abi, Ago, Aki, Ami and Asa are kept complemented between
+ * rounds (lane complementing). With that invariant, chi needs only one NOT
+ * per plane instead of five, and the ANDs and ORs below are chosen so the
+ * same lanes come out complemented again.
+ */
+#define thetaRhoPiChiIota(i, A, E) \
+    Ca = A##ba ^ A##ga ^ A##ka ^ A##ma ^ A##sa; \
+    Ce = A##be ^ A##ge ^ A##ke ^ A##me ^ A##se; \
+    Ci = A##bi ^ A##gi ^ A##ki ^ A##mi ^ A##si; \
+    Co = A##bo ^ A##go ^ A##ko ^ A##mo ^ A##so; \
+    Cu = A##bu ^ A##gu ^ A##ku ^ A##mu ^ A##su; \
+    Da = Cu ^ ROL64(Ce, 1); \
+    De = Ca ^ ROL64(Ci, 1); \
+    Di = Ce ^ ROL64(Co, 1); \
+    Do = Ci ^ ROL64(Cu, 1); \
+    Du = Co ^ ROL64(Ca, 1); \
+\
+    Bba = A##ba ^ Da; \
+    Bbe = ROL64(A##ge ^ De, 44); \
+    Bbi = ROL64(A##ki ^ Di, 43); \
+    Bbo = ROL64(A##mo ^ Do, 21); \
+    Bbu = ROL64(A##su ^ Du, 14); \
+    E##ba = Bba ^ ( Bbe | Bbi ); \
+    E##ba ^= KeccakRoundConstantsOpt64[i]; \
+    E##be = Bbe ^ ((~Bbi) | Bbo ); \
+    E##bi = Bbi ^ ( Bbo & Bbu ); \
+    E##bo = Bbo ^ ( Bbu | Bba ); \
+    E##bu = Bbu ^ ( Bba & Bbe ); \
+\
+    Bga = ROL64(A##bo ^ Do, 28); \
+    Bge = ROL64(A##gu ^ Du, 20); \
+    Bgi = ROL64(A##ka ^ Da,  3); \
+    Bgo = ROL64(A##me ^ De, 45); \
+    Bgu = ROL64(A##si ^ Di, 61); \
+    E##ga = Bga ^ ( Bge | Bgi ); \
+    E##ge = Bge ^ ( Bgi & Bgo ); \
+    E##gi = Bgi ^ ( Bgo | (~Bgu)); \
+    E##go = Bgo ^ ( Bgu | Bga ); \
+    E##gu = Bgu ^ ( Bga & Bge ); \
+\
+    Bka = ROL64(A##be ^ De,  1); \
+    Bke = ROL64(A##gi ^ Di,  6); \
+    Bki = ROL64(A##ko ^ Do, 25); \
+    Bko = ROL64(A##mu ^ Du,  8); \
+    Bku = ROL64(A##sa ^ Da, 18); \
+    E##ka = Bka ^ ( Bke | Bki ); \
+    E##ke = Bke ^ ( Bki & Bko ); \
+    E##ki = Bki ^ ((~Bko) & Bku ); \
+    E##ko = (~Bko) ^ ( Bku | Bka ); \
+    E##ku = Bku ^ ( Bka & Bke ); \
+\
+    Bma = ROL64(A##bu ^ Du, 27); \
+    Bme = ROL64(A##ga ^ Da, 36); \
+    Bmi = ROL64(A##ke ^ De, 10); \
+    Bmo = ROL64(A##mi ^ Di, 15); \
+    Bmu = ROL64(A##so ^ Do, 56); \
+    E##ma = Bma ^ ( Bme & Bmi ); \
+    E##me = Bme ^ ( Bmi | Bmo ); \
+    E##mi = Bmi ^ ((~Bmo) | Bmu ); \
+    E##mo = (~Bmo) ^ ( Bmu & Bma ); \
+    E##mu = Bmu ^ ( Bma | Bme ); \
+\
+    Bsa = ROL64(A##bi ^ Di, 62); \
+    Bse = ROL64(A##go ^ Do, 55); \
+    Bsi = ROL64(A##ku ^ Du, 39); \
+    Bso = ROL64(A##ma ^ Da, 41); \
+    Bsu = ROL64(A##se ^ De,  2); \
+    E##sa = Bsa ^ ((~Bse) & Bsi ); \
+    E##se = (~Bse) ^ ( Bsi | Bso ); \
+    E##si = Bsi ^ ( Bso & Bsu ); \
+    E##so = Bso ^ ( Bsu | Bsa ); \
+    E##su = Bsu ^ ( Bsa & Bse );
+
+/*
+ * Copy the state between the sponge matrix and the local lane variables.
+ * The complemented lanes are flipped on the way in and on the way out.
+ */
+#define loadLanes(state, A) \
+    A##ba =  state[0][0]; A##be = ~state[1][0]; A##bi = ~state[2][0]; A##bo =  state[3][0]; A##bu =  state[4][0]; \
+    A##ga =  state[0][1]; A##ge =  state[1][1]; A##gi =  state[2][1]; A##go = ~state[3][1]; A##gu =  state[4][1]; \
+    A##ka =  state[0][2]; A##ke =  state[1][2]; A##ki = ~state[2][2]; A##ko =  state[3][2]; A##ku =  state[4][2]; \
+    A##ma =  state[0][3]; A##me =  state[1][3]; A##mi = ~state[2][3]; A##mo =  state[3][3]; A##mu =  state[4][3]; \
+    A##sa = ~state[0][4]; A##se =  state[1][4]; A##si =  state[2][4]; A##so =  state[3][4]; A##su =  state[4][4];
+
+#define storeLanes(state, A) \
+    state[0][0] =  A##ba; state[1][0] = ~A##be; state[2][0] = ~A##bi; state[3][0] =  A##bo; state[4][0] =  A##bu; \
+    state[0][1] =  A##ga; state[1][1] =  A##ge; state[2][1] =  A##gi; state[3][1] = ~A##go; state[4][1] =  A##gu; \
+    state[0][2] =  A##ka; state[1][2] =  A##ke; state[2][2] = ~A##ki; state[3][2] =  A##ko; state[4][2] =  A##ku; \
+    state[0][3] =  A##ma; state[1][3] =  A##me; state[2][3] = ~A##mi; state[3][3] =  A##mo; state[4][3] =  A##mu; \
+    state[0][4] = ~A##sa; state[1][4] =  A##se; state[2][4] =  A##si; state[3][4] =  A##so; state[4][4] =  A##su;
+
+#define copyLanes(A, E) \
+    A##ba = E##ba; A##be = E##be; A##bi = E##bi; A##bo = E##bo; A##bu = E##bu; \
+    A##ga = E##ga; A##ge = E##ge; A##gi = E##gi; A##go = E##go; A##gu = E##gu; \
+    A##ka = E##ka; A##ke = E##ke; A##ki = E##ki; A##ko = E##ko; A##ku = E##ku; \
+    A##ma = E##ma; A##me = E##me; A##mi = E##mi; A##mo = E##mo; A##mu = E##mu; \
+    A##sa = E##sa; A##se = E##se; A##si = E##si; A##so = E##so; A##su = E##su;
+
+#define declareLanes(A) \
+    uint64_t A##ba, A##be, A##bi, A##bo, A##bu; \
+    uint64_t A##ga, A##ge, A##gi, A##go, A##gu; \
+    uint64_t A##ka, A##ke, A##ki, A##ko, A##ku; \
+    uint64_t A##ma, A##me, A##mi, A##mo, A##mu; \
+    uint64_t A##sa, A##se, A##si, A##so, A##su;
+
+/*
+ * The permutation body is shared by the generic and the BMI2 entry points and
+ * inlined into each, so each copy is compiled for its own instruction set.
+ */
+#if defined(__GNUC__)
+#define ALWAYS_INLINE __attribute__ ((always_inline))
+#else
+#define ALWAYS_INLINE
+#endif
+
+static inline ALWAYS_INLINE void PermuteOpt64(SpongeMatrix state)
+{
+    declareLanes(A)
+    declareLanes(B)
+    declareLanes(E)
+    uint64_t Ca, Ce, Ci, Co, Cu;
+    uint64_t Da, De, Di, Do, Du;
+
+    loadLanes(state, A)
+
+    thetaRhoPiChiIota( 0, A, E)
+    thetaRhoPiChiIota( 1, E, A)
+    thetaRhoPiChiIota( 2, A, E)
+    thetaRhoPiChiIota( 3, E, A)
+    thetaRhoPiChiIota( 4, A, E)
+    thetaRhoPiChiIota( 5, E, A)
+    thetaRhoPiChiIota( 6, A, E)
+    thetaRhoPiChiIota( 7, E, A)
+    thetaRhoPiChiIota( 8, A, E)
+    thetaRhoPiChiIota( 9, E, A)
+    thetaRhoPiChiIota(10, A, E)
+    thetaRhoPiChiIota(11, E, A)
+    thetaRhoPiChiIota(12, A, E)
+    thetaRhoPiChiIota(13, E, A)
+    thetaRhoPiChiIota(14, A, E)
+    thetaRhoPiChiIota(15, E, A)
+    thetaRhoPiChiIota(16, A, E)
+    thetaRhoPiChiIota(17, E, A)
+    thetaRhoPiChiIota(18, A, E)
+    thetaRhoPiChiIota(19, E, A)
+    thetaRhoPiChiIota(20, A, E)
+    thetaRhoPiChiIota(21, E, A)
+    thetaRhoPiChiIota(22, A, E)
+    thetaRhoPiChiIota(23, E, A)
+
+    storeLanes(state, A)
+}
+
+/*
+ * Keccak-p[1600, rounds] runs the last rounds of the schedule two at a time,
+ * so the lanes end up in A again. An odd count starts with a single round.
+ */
+static inline ALWAYS_INLINE void PermuteRoundsOpt64(SpongeMatrix state, uint32_t rounds)
+{
+    declareLanes(A)
+    declareLanes(B)
+    declareLanes(E)
+    uint64_t Ca, Ce, Ci, Co, Cu;
+    uint64_t Da, De, Di, Do, Du;
+    uint32_t round = 24 - rounds;
+
+    loadLanes(state, A)
+
+    if ((rounds % 2) != 0) {
+        thetaRhoPiChiIota(round, A, E)
+        copyLanes(A, E)
+        round++;
+    }
+
+    for(; round < 24; round += 2) {
+        thetaRhoPiChiIota(round,     A, E)
+        thetaRhoPiChiIota(round + 1, E, A)
+    }
+
+    storeLanes(state, A)
+}
+
+void KeccakPermutationOpt64(SpongeMatrix state)
+{
+    PermuteOpt64(state);
+}
+
+void KeccakPermutationRoundsOpt64(SpongeMatrix state, uint32_t rounds)
+{
+    PermuteRoundsOpt64(state, rounds);
+}
+
+#if defined(KECCAK_X86)
+__attribute__ ((target("bmi,bmi2")))
+void KeccakPermutationOpt64BMI2(SpongeMatrix state)
+{
+    PermuteOpt64(state);
+}
+
+__attribute__ ((target("bmi,bmi2")))
+void KeccakPermutationRoundsOpt64BMI2(SpongeMatrix state, uint32_t rounds)
+{
+    PermuteRoundsOpt64(state, rounds);
+}
+#endif
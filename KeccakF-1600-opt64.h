@@ -0,0 +1,43 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include "KeccakSponge.h"
+
+/**
+  * Run a permutation of KeccakF using the optimized 64-bit implementation.
+  * The rounds are fully unrolled, theta, rho, pi, chi and iota are computed
+  * in one pass per round, and the lanes are held in local variables.
+  * The result is identical to KeccakPermutationReference().
+  * @param  state       Pointer to the sponge matrix.
+  */
+void KeccakPermutationOpt64(SpongeMatrix state);
+
+/**
+  * Run Keccak-p[1600, rounds], the last @a rounds rounds of KeccakF, using the
+  * optimized 64-bit implementation. The result is identical to KeccakPermutationRoundsReference().
+  * @param  state       Pointer to the sponge matrix.
+  * @param  rounds      Number of rounds, from 1 to 24.
+  */
+void KeccakPermutationRoundsOpt64(SpongeMatrix state, uint32_t rounds);
+
+#if defined(KECCAK_X86)
+/**
+  * Run a permutation of KeccakF using the optimized 64-bit implementation,
+  * compiled for CPUs with BMI1 and BMI2 so that the compiler can use ANDN for
+  * chi and RORX for the rotations.
+  * Only call it when the CPU supports both extensions.
+  * @param  state       Pointer to the sponge matrix.
+  */
+void KeccakPermutationOpt64BMI2(SpongeMatrix state);
+
+/**
+  * Run Keccak-p[1600, rounds] using the optimized 64-bit implementation compiled for BMI1 and BMI2.
+  * Only call it when the CPU supports both extensions.
+  * @param  state       Pointer to the sponge matrix.
+  * @param  rounds      Number of rounds, from 1 to 24.
+  */
+void KeccakPermutationRoundsOpt64BMI2(SpongeMatrix state, uint32_t rounds);
+#endif
@@ -7,12 +7,41 @@
 
 #include "KeccakSponge.h"
 #include "KeccakF-1600-reference.h"
+#include "KeccakErase.h"
 
-uint64_t KeccakRoundConstants[nrRounds];
-uint64_t KeccakRhoOffsets[nrRows][nrCols];
+/*
+ * Keccak Constants
+ *
+ * The round constants and rho offsets never change, so they are stored as
+ * read-only tables instead of being computed on every initialization.
+ * KeccakVerifyConstants() regenerates them with the LFSR and the rho
+ * recurrence below to check the tables.
+ */
+static const uint64_t KeccakRoundConstants[nrRounds] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL,
+    0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL,
+    0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL,
+    0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL,
+    0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+
+static const uint32_t KeccakRhoOffsets[nrRows][nrCols] = {
+    { 0, 36,  3, 41, 18},
+    { 1, 44, 10, 45,  2},
+    {62,  6, 43, 15, 61},
+    {28, 55, 25, 21, 56},
+    {27, 20, 39,  8, 14},
+};
 
 /*
- * Keccak Initialization Functions
+ * Keccak Constant Generation Functions
  */
 int32_t LFSR86540(uint8_t * LFSR)
 {
@@ -27,37 +56,37 @@ int32_t LFSR86540(uint8_t * LFSR)
     return result;
 }
 
-void KeccakInitializeRoundConstants()
+void KeccakComputeRoundConstants(uint64_t roundConstants[nrRounds])
 {
     uint8_t LFSRstate = 0x01;
     uint32_t bitPosition;
     
     uint32_t i, j;
     for(i = 0; i < nrRounds; i++) {
-        KeccakRoundConstants[i] = 0;
+        roundConstants[i] = 0;
 
         for(j = 0; j < 7; j++) {
             bitPosition = (1 << j) - 1; // 2^j - 1
 
             if(LFSR86540(&LFSRstate)) {
-                KeccakRoundConstants[i] ^= (uint64_t) 1 << bitPosition;
+                roundConstants[i] ^= (uint64_t) 1 << bitPosition;
             }
         }
     }
 }
 
-void KeccakInitializeRhoOffsets()
+void KeccakComputeRhoOffsets(uint32_t rhoOffsets[nrRows][nrCols])
 {
     uint32_t x, y, newX, newY;
 
-    KeccakRhoOffsets[0][0] = 0;
+    rhoOffsets[0][0] = 0;
 
     x = 1;
     y = 0;
 
     uint32_t t;
     for(t = 0; t < 24; t++) {
-        KeccakRhoOffsets[x][y] = ((t + 1) * (t + 2)/2) % 64;
+        rhoOffsets[x][y] = ((t + 1) * (t + 2)/2) % 64;
 
         newX = (0 * x + 1 * y) % 5;
         newY = (2 * x + 3 * y) % 5;
@@ -67,38 +96,92 @@ void KeccakInitializeRhoOffsets()
     }
 }
 
-void KeccakInitialize(SpongeMatrix state)
+int32_t KeccakVerifyConstants(void)
 {
-    KeccakInitializeRoundConstants();
-    KeccakInitializeRhoOffsets();
+    uint64_t roundConstants[nrRounds];
+    uint32_t rhoOffsets[nrRows][nrCols];
+
+    KeccakComputeRoundConstants(roundConstants);
+    KeccakComputeRhoOffsets(rhoOffsets);
 
+    return (memcmp(roundConstants, KeccakRoundConstants, sizeof(roundConstants)) == 0)
+        && (memcmp(rhoOffsets, KeccakRhoOffsets, sizeof(rhoOffsets)) == 0);
+}
+
+/*
+ * Keccak Initialization
+ */
+void KeccakInitialize(SpongeMatrix state)
+{
     memset(state, 0, sizeof(uint64_t) * nrRows * nrCols);
 }
 
+/*
+ * Lane <-> Byte conversion
+ *
+ * Lanes are little-endian, so byte i of the state is byte i % 8 of lane i / 8.
+ * Loading and storing byte by byte keeps this independent of the host byte order.
+ */
+static uint64_t load64(const uint8_t * x)
+{
+    return  ((uint64_t) x[0])        | ((uint64_t) x[1] <<  8)
+         | ((uint64_t) x[2] << 16) | ((uint64_t) x[3] << 24)
+         | ((uint64_t) x[4] << 32) | ((uint64_t) x[5] << 40)
+         | ((uint64_t) x[6] << 48) | ((uint64_t) x[7] << 56);
+}
+
+static void store64(uint8_t * x, uint64_t lane)
+{
+    uint32_t i;
+    for(i = 0; i < 8; i++) {
+        x[i] = (uint8_t) (lane >> (8 * i));
+    }
+}
+
 /*
  * Absorb and Permute
  */
-void KeccakXorDataIntoState(SpongeMatrix state, const uint8_t * data, uint32_t dataLengthInBytes)
+void KeccakXorBytesIntoState(SpongeMatrix state, const uint8_t * data, uint32_t offset, uint32_t length)
 {
-    uint8_t stateArray[KeccakPermutationSizeInBytes];
+    // Leading bytes up to the next lane boundary
+    while((length > 0) && ((offset % 8) != 0)) {
+        SpongeLane(state, offset / 8) ^= (uint64_t) *data << (8 * (offset % 8));
+        data++;
+        offset++;
+        length--;
+    }
 
-    stateMatrixToArray(state, stateArray);
+    // Whole lanes
+    while(length >= 8) {
+        SpongeLane(state, offset / 8) ^= load64(data);
+        data += 8;
+        offset += 8;
+        length -= 8;
+    }
 
-    uint32_t i;
-    for(i = 0; i < dataLengthInBytes; i++)
-    {
-        stateArray[i] ^= data[i];
+    // Trailing bytes of the last lane
+    while(length > 0) {
+        SpongeLane(state, offset / 8) ^= (uint64_t) *data << (8 * (offset % 8));
+        data++;
+        offset++;
+        length--;
     }
+}
 
-    stateArrayToMatrix(stateArray, state);
+void KeccakXorDataIntoState(SpongeMatrix state, const uint8_t * data, uint32_t dataLengthInBytes)
+{
+    KeccakXorBytesIntoState(state, data, 0, dataLengthInBytes);
+}
 
-    memset(&stateArray, 0, sizeof(stateArray)); // Clear memory of secret data
+void KeccakPermutationReference(SpongeMatrix state)
+{
+    KeccakPermutationRoundsReference(state, nrRounds);
 }
 
-void KeccakPermutation(SpongeMatrix state)
+void KeccakPermutationRoundsReference(SpongeMatrix state, uint32_t rounds)
 {
     uint32_t round;
-    for(round = 0; round < nrRounds; round++) {
+    for(round = nrRounds - rounds; round < nrRounds; round++) {
         theta(state);
         rho(state);
         pi(state);
@@ -113,11 +196,18 @@ void KeccakAbsorb(SpongeMatrix state, const uint8_t * data, uint32_t rate)
     KeccakPermutation(state);
 }
 
+void KeccakAbsorbRounds(SpongeMatrix state, const uint8_t * data, uint32_t rate, uint32_t rounds)
+{
+    KeccakXorDataIntoState(state, data, rate/8);
+    KeccakPermutationRounds(state, rounds);
+}
+
 /*
  * Keccak Round Steps
  */
 uint64_t ROL64(uint64_t a, uint32_t offset) {
-    return ( ((uint64_t) a) << offset ) | ( ((uint64_t) a) >> (64 - offset) );
+    // The right shift is taken modulo 64 so that an offset of 0 (lane [0][0] in rho) is defined
+    return ( ((uint64_t) a) << offset ) | ( ((uint64_t) a) >> ((64 - offset) % 64) );
 }
 
 void theta(SpongeMatrix A)
@@ -141,8 +231,8 @@ void theta(SpongeMatrix A)
     }
 
     // Clear memory of secret data
-    memset(&C, 0, sizeof(C));
-    memset(&D, 0, sizeof(D));
+    KeccakEraseStep(&C, sizeof(C));
+    KeccakEraseStep(&D, sizeof(D));
 }
 
 void rho(SpongeMatrix A)
@@ -174,7 +264,7 @@ void pi(SpongeMatrix A)
         }
     }
 
-    memset(&tempA, 0, sizeof(tempA)); // Clear memory of secret data
+    KeccakEraseStep(&tempA, sizeof(tempA)); // Clear memory of secret data
 }
 
 void chi(SpongeMatrix A)
@@ -191,7 +281,7 @@ void chi(SpongeMatrix A)
         }
     }
 
-    memset(&C, 0, sizeof(C)); // Clear memory of secret data
+    KeccakEraseStep(&C, sizeof(C)); // Clear memory of secret data
 }
 
 void iota(SpongeMatrix A, uint32_t indexRound)
@@ -202,42 +292,34 @@ void iota(SpongeMatrix A, uint32_t indexRound)
 /*
  * Squeezing
  */
-void KeccakExtract(SpongeMatrix state, uint8_t * data, uint32_t rate)
+void KeccakExtractBytes(SpongeMatrix state, uint8_t * data, uint32_t offset, uint32_t length)
 {
-    uint8_t stateArray[KeccakPermutationSizeInBytes];
-
-    stateMatrixToArray(state, stateArray);
-
-    memcpy(data, stateArray, rate/8);
-
-    memset(&stateArray, 0, sizeof(stateArray)); // Clear memory of secret data
-}
+    // Leading bytes up to the next lane boundary
+    while((length > 0) && ((offset % 8) != 0)) {
+        *data = (uint8_t) (SpongeLane(state, offset / 8) >> (8 * (offset % 8)));
+        data++;
+        offset++;
+        length--;
+    }
 
-/*
- *  Matrix <-> Array conversion for easy Absorption and Extraction
- */
-void stateArrayToMatrix(uint8_t * state, SpongeMatrix stateMatrix) {
-    // Cast the 200-byte array into a 25-word array
-    uint64_t * stateWordArray = (uint64_t * ) state;
+    // Whole lanes
+    while(length >= 8) {
+        store64(data, SpongeLane(state, offset / 8));
+        data += 8;
+        offset += 8;
+        length -= 8;
+    }
 
-    // Copy the array elements into the matrix
-    uint32_t x, y;
-    for(x = 0; x < nrRows; x++) {
-        for(y = 0; y < nrCols; y++) {
-            stateMatrix[x][y] = stateWordArray[x + (5 * y)];
-        }
+    // Trailing bytes of the last lane
+    while(length > 0) {
+        *data = (uint8_t) (SpongeLane(state, offset / 8) >> (8 * (offset % 8)));
+        data++;
+        offset++;
+        length--;
     }
 }
 
-void stateMatrixToArray(SpongeMatrix state, uint8_t * stateArray) {
-    // Cast the 200-byte array into a 25-word array
-    uint64_t * stateWordArray = (uint64_t * ) stateArray;
-
-    // Copy the matrix elements into the array
-    uint32_t x, y;
-    for(x = 0; x < nrRows; x++) {
-        for(y = 0; y < nrCols; y++) {
-            stateWordArray[x + (5 * y)] = state[x][y];
-        }
-    }
+void KeccakExtract(SpongeMatrix state, uint8_t * data, uint32_t rate)
+{
+    KeccakExtractBytes(state, data, 0, rate/8);
 }
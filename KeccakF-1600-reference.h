@@ -12,7 +12,8 @@
 #define nrCols    5
 
 /**
-  * Initialize the sponge matrix and constants.
+  * Initialize the sponge matrix.
+  * The round constants and rho offsets are constant tables, so this only clears the state.
   * @param  state       Pointer to the sponge matrix.
   */
 void KeccakInitialize(SpongeMatrix state);
@@ -25,32 +26,86 @@ void KeccakInitialize(SpongeMatrix state);
   */
 void KeccakAbsorb(SpongeMatrix state, const uint8_t * data, uint32_t rate);
 
+/**
+  * Absorb the input data into the sponge matrix using Keccak-p[1600, rounds].
+  * @param  state       Pointer to the sponge matrix.
+  * @param  data        Pointer to the input data.
+  * @param  rate        Rate of the KeccakF algorithm
+  * @param  rounds      Number of rounds, from 1 to nrRounds.
+  */
+void KeccakAbsorbRounds(SpongeMatrix state, const uint8_t * data, uint32_t rate, uint32_t rounds);
+
 /**
   * Run a permutation of KeccakF.
+  * This calls the active backend, see KeccakF-1600-dispatch.h.
   * @param  state       Pointer to the sponge matrix.
   */
 void KeccakPermutation(SpongeMatrix state);
 
 /**
-  * Absorb the input data into the sponge matrix.
+  * Run Keccak-p[1600, rounds], the last @a rounds rounds of KeccakF, e.g. 12 for KangarooTwelve.
+  * With rounds = nrRounds this is KeccakPermutation().
+  * This calls the active backend, see KeccakF-1600-dispatch.h.
+  * @param  state       Pointer to the sponge matrix.
+  * @param  rounds      Number of rounds, from 1 to nrRounds.
+  */
+void KeccakPermutationRounds(SpongeMatrix state, uint32_t rounds);
+
+/**
+  * Run a permutation of KeccakF using the step-by-step reference round functions.
+  * @param  state       Pointer to the sponge matrix.
+  */
+void KeccakPermutationReference(SpongeMatrix state);
+
+/**
+  * Run Keccak-p[1600, rounds] using the step-by-step reference round functions.
+  * @param  state       Pointer to the sponge matrix.
+  * @param  rounds      Number of rounds, from 1 to nrRounds.
+  */
+void KeccakPermutationRoundsReference(SpongeMatrix state, uint32_t rounds);
+
+/**
+  * Extract one block of output data from the sponge matrix.
   * @param  state       Pointer to the sponge matrix.
   * @param  data        Pointer to the output data.
   * @param  rate        Rate of the KeccakF algorithm
   */
 void KeccakExtract(SpongeMatrix state, uint8_t * data, uint32_t rate);
 
+/**
+  * XOR bytes into the sponge matrix in place, viewing it as 200 bytes.
+  * Whole lanes are XORed a word at a time; only the lanes covered are touched.
+  * @param  state       Pointer to the sponge matrix.
+  * @param  data        Pointer to the input data.
+  * @param  offset      Byte offset into the state where the data starts.
+  * @param  length      Number of bytes to XOR, with offset + length <= 200.
+  */
+void KeccakXorBytesIntoState(SpongeMatrix state, const uint8_t * data, uint32_t offset, uint32_t length);
+
+/**
+  * Copy bytes out of the sponge matrix in place, viewing it as 200 bytes.
+  * Whole lanes are copied a word at a time; only the lanes covered are read.
+  * @param  state       Pointer to the sponge matrix.
+  * @param  data        Pointer to the output data.
+  * @param  offset      Byte offset into the state where the output starts.
+  * @param  length      Number of bytes to copy, with offset + length <= 200.
+  */
+void KeccakExtractBytes(SpongeMatrix state, uint8_t * data, uint32_t offset, uint32_t length);
+
 /*
  * Internal round functions
  */
 
-// Initialization
-int32_t LFSR86540(uint8_t * LFSR);
-void KeccakInitializeRoundConstants();
-void KeccakInitializeRhoOffsets();
+/**
+  * Regenerate the round constants and rho offsets and compare them to the constant tables.
+  * @return 1 if the tables are correct, 0 otherwise.
+  */
+int32_t KeccakVerifyConstants(void);
 
-// Matrix <-> Array Conversion
-void stateArrayToMatrix(uint8_t * state, SpongeMatrix stateMatrix);
-void stateMatrixToArray(SpongeMatrix state, uint8_t * stateArray);
+// Constant generation
+int32_t LFSR86540(uint8_t * LFSR);
+void KeccakComputeRoundConstants(uint64_t roundConstants[nrRounds]);
+void KeccakComputeRhoOffsets(uint32_t rhoOffsets[nrRows][nrCols]);
 
 // Absorbtion
 void KeccakXorDataIntoState(SpongeMatrix state, const uint8_t * data, uint32_t dataLengthInBytes);
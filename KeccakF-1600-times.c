@@ -0,0 +1,120 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+#include "KeccakF-1600-reference.h"
+#include "KeccakF-1600-times.h"
+#include "KeccakF-1600-dispatch.h"
+#include "KeccakInstrumentation.h"
+
+/*
+ * Four states
+ */
+void KeccakPermutationTimes4(SpongeMatrix states[4])
+{
+    KeccakPermutationRoundsTimes4(states, nrRounds);
+}
+
+void KeccakPermutationRoundsTimes4(SpongeMatrix states[4], uint32_t rounds)
+{
+    const KeccakBackend * backend = KeccakGetBackend();
+
+    if (backend->permutationTimes4 != NULL) {
+        KeccakTimerStart(start);
+        backend->permutationTimes4(states, rounds);
+        KeccakCount(permutations, 4);
+        KeccakTimerStop(permutationNanoseconds, start);
+        return;
+    }
+
+    uint32_t i;
+    for(i = 0; i < 4; i++) {
+        KeccakPermutationRounds(states[i], rounds);
+    }
+}
+
+void KeccakAbsorbTimes4(SpongeMatrix states[4], const uint8_t * const data[4], uint32_t rate)
+{
+    KeccakAbsorbRoundsTimes4(states, data, rate, nrRounds);
+}
+
+void KeccakAbsorbRoundsTimes4(SpongeMatrix states[4], const uint8_t * const data[4], uint32_t rate, uint32_t rounds)
+{
+    const KeccakBackend * backend = KeccakGetBackend();
+
+    if (backend->absorbTimes4 != NULL) {
+        KeccakTimerStart(start);
+        backend->absorbTimes4(states, data, rate, rounds);
+        KeccakCount(permutations, 4);
+        KeccakTimerStop(permutationNanoseconds, start);
+        return;
+    }
+
+    uint32_t i;
+    for(i = 0; i < 4; i++) {
+        KeccakAbsorbRounds(states[i], data[i], rate, rounds);
+    }
+}
+
+void KeccakExtractTimes4(SpongeMatrix states[4], uint8_t * const data[4], uint32_t rate)
+{
+    uint32_t i;
+    for(i = 0; i < 4; i++) {
+        KeccakExtract(states[i], data[i], rate);
+    }
+}
+
+/*
+ * Eight states, as two groups of four when the backend has no 8-way permutation
+ */
+void KeccakPermutationTimes8(SpongeMatrix states[8])
+{
+    KeccakPermutationRoundsTimes8(states, nrRounds);
+}
+
+void KeccakPermutationRoundsTimes8(SpongeMatrix states[8], uint32_t rounds)
+{
+    const KeccakBackend * backend = KeccakGetBackend();
+
+    if (backend->permutationTimes8 != NULL) {
+        KeccakTimerStart(start);
+        backend->permutationTimes8(states, rounds);
+        KeccakCount(permutations, 8);
+        KeccakTimerStop(permutationNanoseconds, start);
+        return;
+    }
+
+    KeccakPermutationRoundsTimes4(states, rounds);
+    KeccakPermutationRoundsTimes4(states + 4, rounds);
+}
+
+void KeccakAbsorbTimes8(SpongeMatrix states[8], const uint8_t * const data[8], uint32_t rate)
+{
+    KeccakAbsorbRoundsTimes8(states, data, rate, nrRounds);
+}
+
+void KeccakAbsorbRoundsTimes8(SpongeMatrix states[8], const uint8_t * const data[8], uint32_t rate, uint32_t rounds)
+{
+    const KeccakBackend * backend = KeccakGetBackend();
+
+    if (backend->absorbTimes8 != NULL) {
+        KeccakTimerStart(start);
+        backend->absorbTimes8(states, data, rate, rounds);
+        KeccakCount(permutations, 8);
+        KeccakTimerStop(permutationNanoseconds, start);
+        return;
+    }
+
+    KeccakAbsorbRoundsTimes4(states, data, rate, rounds);
+    KeccakAbsorbRoundsTimes4(states + 4, data + 4, rate, rounds);
+}
+
+void KeccakExtractTimes8(SpongeMatrix states[8], uint8_t * const data[8], uint32_t rate)
+{
+    KeccakExtractTimes4(states, data, rate);
+    KeccakExtractTimes4(states + 4, data + 4, rate);
+}
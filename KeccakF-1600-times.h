@@ -0,0 +1,107 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include "KeccakSponge.h"
+
+/*
+ * Multi-state KeccakF
+ *
+ * These functions run the permutation on 4 or 8 independent states at once,
+ * using the multi-state functions of the active backend (see
+ * KeccakF-1600-dispatch.h). The AVX2 and AVX-512 backends hold one lane of
+ * every state in each vector register; the other backends call their
+ * single-state permutation on each state in turn. The results are always
+ * identical to the single-state functions.
+ */
+
+#define KeccakMaxParallelism 8
+
+/**
+  * Run a permutation of KeccakF on four states.
+  * @param  states      Array of four sponge matrices.
+  */
+void KeccakPermutationTimes4(SpongeMatrix states[4]);
+
+/**
+  * Run Keccak-p[1600, rounds] on four states.
+  * @param  states      Array of four sponge matrices.
+  * @param  rounds      Number of rounds, from 1 to 24.
+  */
+void KeccakPermutationRoundsTimes4(SpongeMatrix states[4], uint32_t rounds);
+
+/**
+  * Absorb one block of input data into each of four states.
+  * @param  states      Array of four sponge matrices.
+  * @param  data        Pointers to one block of input data per state.
+  * @param  rate        Rate of the KeccakF algorithm
+  */
+void KeccakAbsorbTimes4(SpongeMatrix states[4], const uint8_t * const data[4], uint32_t rate);
+
+/**
+  * Absorb one block of input data into each of four states using Keccak-p[1600, rounds].
+  * @param  states      Array of four sponge matrices.
+  * @param  data        Pointers to one block of input data per state.
+  * @param  rate        Rate of the KeccakF algorithm
+  * @param  rounds      Number of rounds, from 1 to 24.
+  */
+void KeccakAbsorbRoundsTimes4(SpongeMatrix states[4], const uint8_t * const data[4], uint32_t rate, uint32_t rounds);
+
+/**
+  * Extract one block of output data from each of four states.
+  * @param  states      Array of four sponge matrices.
+  * @param  data        Pointers to one block of output buffer per state.
+  * @param  rate        Rate of the KeccakF algorithm
+  */
+void KeccakExtractTimes4(SpongeMatrix states[4], uint8_t * const data[4], uint32_t rate);
+
+/**
+  * Run a permutation of KeccakF on eight states.
+  * @param  states      Array of eight sponge matrices.
+  */
+void KeccakPermutationTimes8(SpongeMatrix states[8]);
+
+/**
+  * Run Keccak-p[1600, rounds] on eight states.
+  * @param  states      Array of eight sponge matrices.
+  * @param  rounds      Number of rounds, from 1 to 24.
+  */
+void KeccakPermutationRoundsTimes8(SpongeMatrix states[8], uint32_t rounds);
+
+/**
+  * Absorb one block of input data into each of eight states.
+  * @param  states      Array of eight sponge matrices.
+  * @param  data        Pointers to one block of input data per state.
+  * @param  rate        Rate of the KeccakF algorithm
+  */
+void KeccakAbsorbTimes8(SpongeMatrix states[8], const uint8_t * const data[8], uint32_t rate);
+
+/**
+  * Absorb one block of input data into each of eight states using Keccak-p[1600, rounds].
+  * @param  states      Array of eight sponge matrices.
+  * @param  data        Pointers to one block of input data per state.
+  * @param  rate        Rate of the KeccakF algorithm
+  * @param  rounds      Number of rounds, from 1 to 24.
+  */
+void KeccakAbsorbRoundsTimes8(SpongeMatrix states[8], const uint8_t * const data[8], uint32_t rate, uint32_t rounds);
+
+/**
+  * Extract one block of output data from each of eight states.
+  * @param  states      Array of eight sponge matrices.
+  * @param  data        Pointers to one block of output buffer per state.
+  * @param  rate        Rate of the KeccakF algorithm
+  */
+void KeccakExtractTimes8(SpongeMatrix states[8], uint8_t * const data[8], uint32_t rate);
+
+/*
+ * SIMD implementations, only called through backends whose CPU check passed
+ */
+#if defined(KECCAK_X86)
+void KeccakPermutationTimes4AVX2(SpongeMatrix states[4], uint32_t rounds);
+void KeccakAbsorbTimes4AVX2(SpongeMatrix states[4], const uint8_t * const data[4], uint32_t rate, uint32_t rounds);
+
+void KeccakPermutationTimes8AVX512(SpongeMatrix states[8], uint32_t rounds);
+void KeccakAbsorbTimes8AVX512(SpongeMatrix states[8], const uint8_t * const data[8], uint32_t rate, uint32_t rounds);
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+#include "KeccakErase.h"
+#include "KeccakFIPS202.h"
+
+static int32_t IsSHA3Length(uint32_t hashBitLen)
+{
+    return (hashBitLen == 224) || (hashBitLen == 256) || (hashBitLen == 384) || (hashBitLen == 512);
+}
+
+SpongeReturn InitSHA3(SpongeState * state, uint32_t hashBitLen)
+{
+    SpongeReturn returnVal;
+
+    if (!IsSHA3Length(hashBitLen)) {
+        return BAD_HASHLEN;
+    }
+
+    returnVal = InitSponge(state, 1600 - 2 * hashBitLen, 2 * hashBitLen);
+    state->delimitedSuffix = SHA3DelimitedSuffix;
+    state->fixedOutputLength = hashBitLen;
+
+    return returnVal;
+}
+
+SpongeReturn InitSHAKE(SpongeState * state, uint32_t securityStrength)
+{
+    SpongeReturn returnVal;
+
+    if ((securityStrength != 128) && (securityStrength != 256)) {
+        return BAD_RATE_CAPACITY;
+    }
+
+    returnVal = InitSponge(state, 1600 - 2 * securityStrength, 2 * securityStrength);
+    state->delimitedSuffix = SHAKEDelimitedSuffix;
+
+    return returnVal;
+}
+
+SpongeReturn SHA3(uint32_t hashBitLen, const uint8_t * data, uint64_t dataByteLen, uint8_t * output)
+{
+    SpongeMatrix state;
+
+    if (!IsSHA3Length(hashBitLen)) {
+        return BAD_HASHLEN;
+    }
+
+    SpongeOneShot(state, 1600 - 2 * hashBitLen, SHA3DelimitedSuffix, data, dataByteLen, output, hashBitLen / 8);
+
+    KeccakErase(&state, sizeof(state)); // Clear memory of secret data
+    KeccakEraseStack();
+
+    return SUCCESS;
+}
+
+SpongeReturn SHAKE(uint32_t securityStrength, const uint8_t * data, uint64_t dataByteLen,
+                   uint8_t * output, uint64_t outputBitLen)
+{
+    SpongeMatrix state;
+
+    if ((securityStrength != 128) && (securityStrength != 256)) {
+        return BAD_RATE_CAPACITY;
+    }
+    if ((outputBitLen % 8) != 0) {
+        return BAD_HASHLEN;
+    }
+
+    SpongeOneShot(state, 1600 - 2 * securityStrength, SHAKEDelimitedSuffix, data, dataByteLen, output, outputBitLen / 8);
+
+    KeccakErase(&state, sizeof(state)); // Clear memory of secret data
+    KeccakEraseStack();
+
+    return SUCCESS;
+}
+
+SpongeReturn SHAKE128(const uint8_t * data, uint64_t dataByteLen, uint8_t * output, uint64_t outputBitLen)
+{
+    return SHAKE(128, data, dataByteLen, output, outputBitLen);
+}
+
+SpongeReturn SHAKE256(const uint8_t * data, uint64_t dataByteLen, uint8_t * output, uint64_t outputBitLen)
+{
+    return SHAKE(256, data, dataByteLen, output, outputBitLen);
+}
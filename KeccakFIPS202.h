@@ -0,0 +1,76 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+
+/*
+ * FIPS 202: SHA3-224, SHA3-256, SHA3-384, SHA3-512, SHAKE128 and SHAKE256
+ *
+ * SHA3-n is Keccak[2n](M || 01, n) and SHAKE128/256 is Keccak[2s](M || 1111, d).
+ * For incremental use, InitSHA3() and InitSHAKE() set up a SpongeState with the
+ * right capacity and suffix; the message is then given with Absorb() and the
+ * output read with Squeeze(). A XOF may be squeezed in as many calls as needed,
+ * and whole blocks are written straight into the caller's buffer.
+ */
+
+/**
+  * Initialize a sponge for SHA3-n.
+  * @param  state       Pointer to the state of the sponge function to be initialized.
+  * @param  hashBitLen  The digest length n: 224, 256, 384 or 512.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The digest length is not supported.
+  *         SUCCESS     - Sponge initialized
+  */
+SpongeReturn InitSHA3(SpongeState * state, uint32_t hashBitLen);
+
+/**
+  * Initialize a sponge for SHAKE128 or SHAKE256.
+  * @param  state       Pointer to the state of the sponge function to be initialized.
+  * @param  securityStrength    128 or 256.
+  * @return SpongeReturn
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         SUCCESS           - Sponge initialized
+  */
+SpongeReturn InitSHAKE(SpongeState * state, uint32_t securityStrength);
+
+/**
+  * Compute SHA3-n of a byte-aligned message.
+  * @param  hashBitLen  The digest length n: 224, 256, 384 or 512.
+  * @param  data        Pointer to the input data.
+  * @param  dataByteLen The number of input bytes.
+  * @param  output      Pointer to the buffer where to store the n/8 bytes of digest.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The digest length is not supported.
+  *         SUCCESS     - The digest was computed.
+  */
+SpongeReturn SHA3(uint32_t hashBitLen, const uint8_t * data, uint64_t dataByteLen, uint8_t * output);
+
+/**
+  * Compute SHAKE128 or SHAKE256 of a byte-aligned message.
+  * @param  securityStrength    128 or 256.
+  * @param  data        Pointer to the input data.
+  * @param  dataByteLen The number of input bytes.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits d, a multiple of 8.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The output length is not a multiple of 8 bits.
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         SUCCESS     - The output was computed.
+  */
+SpongeReturn SHAKE(uint32_t securityStrength, const uint8_t * data, uint64_t dataByteLen,
+                   uint8_t * output, uint64_t outputBitLen);
+
+/**
+  * SHAKE128(M, d), see SHAKE().
+  */
+SpongeReturn SHAKE128(const uint8_t * data, uint64_t dataByteLen, uint8_t * output, uint64_t outputBitLen);
+
+/**
+  * SHAKE256(M, d), see SHAKE().
+  */
+SpongeReturn SHAKE256(const uint8_t * data, uint64_t dataByteLen, uint8_t * output, uint64_t outputBitLen);
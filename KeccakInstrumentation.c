@@ -0,0 +1,45 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "KeccakInstrumentation.h"
+
+#if defined(KECCAK_INSTRUMENTATION)
+
+__thread KeccakCounters keccakThreadCounters;
+
+uint64_t KeccakInstrumentationClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+void KeccakCountersSnapshot(KeccakCounters * counters)
+{
+    *counters = keccakThreadCounters;
+}
+
+void KeccakCountersReset(void)
+{
+    memset(&keccakThreadCounters, 0, sizeof(KeccakCounters));
+}
+
+#else
+
+void KeccakCountersSnapshot(KeccakCounters * counters)
+{
+    memset(counters, 0, sizeof(KeccakCounters));
+}
+
+void KeccakCountersReset(void)
+{
+}
+
+#endif
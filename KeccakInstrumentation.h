@@ -0,0 +1,75 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Hot-path counters, compiled in with -DKECCAK_INSTRUMENTATION.
+ *
+ * Each thread counts the permutations it runs, how its input reached the
+ * state, the extra blocks caused by padding and the time spent in the
+ * permutation, absorbing and squeezing layers. The layers nest: the time
+ * spent absorbing includes the permutations run while absorbing.
+ *
+ * Without KECCAK_INSTRUMENTATION the counting macros expand to nothing, so
+ * the hot paths are compiled exactly as before, and a snapshot is all zeros.
+ */
+
+typedef struct {
+    // Permutations of a single state, multi-state calls counting one per state
+    uint64_t permutations;
+
+    // Bytes absorbed as whole blocks straight from the input, and the number of those blocks
+    uint64_t fastPathBytes;
+    uint64_t fastPathBlocks;
+
+    // Bytes XORed into a partially filled block
+    uint64_t partialBlockBytes;
+
+    // Permutations caused only by the delimited suffix or the pad10*1 not fitting in the open block
+    uint64_t paddingBlocks;
+
+    // Bytes of output squeezed
+    uint64_t squeezedBytes;
+
+    // Time spent in each layer, in nanoseconds
+    uint64_t permutationNanoseconds;
+    uint64_t absorbNanoseconds;
+    uint64_t squeezeNanoseconds;
+} KeccakCounters;
+
+/**
+  * Read the counters of the calling thread.
+  * @param  counters    Pointer to the snapshot, all zeros when instrumentation is compiled out.
+  */
+void KeccakCountersSnapshot(KeccakCounters * counters);
+
+/**
+  * Set the counters of the calling thread to zero.
+  */
+void KeccakCountersReset(void);
+
+#if defined(KECCAK_INSTRUMENTATION)
+
+extern __thread KeccakCounters keccakThreadCounters;
+
+/**
+  * Read a monotonic clock for the layer timers.
+  * @return Time in nanoseconds.
+  */
+uint64_t KeccakInstrumentationClock(void);
+
+#define KeccakCount(counter, amount) (keccakThreadCounters.counter += (amount))
+#define KeccakTimerStart(timer) uint64_t timer = KeccakInstrumentationClock()
+#define KeccakTimerStop(counter, timer) (keccakThreadCounters.counter += KeccakInstrumentationClock() - (timer))
+
+#else
+
+#define KeccakCount(counter, amount)
+#define KeccakTimerStart(timer)
+#define KeccakTimerStop(counter, timer)
+
+#endif
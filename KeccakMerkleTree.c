@@ -0,0 +1,250 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "KeccakSponge.h"
+#include "KeccakErase.h"
+#include "KeccakFIPS202.h"
+#include "KeccakThreadPool.h"
+#include "KeccakMerkleTree.h"
+
+#define MerkleTaskBytes (1 << 16)   // Input hashed by one task of the thread pool
+#define MerkleLeafPrefix 0x00
+#define MerkleNodePrefix 0x01
+#define MerkleSHA3_256Rate 1088
+
+// Input of an interior node: the prefix byte and the two children, under one block of SHA3-256
+#define MerkleNodeInputByteLen (1 + 2 * KeccakMerkleTreeNodeByteLen)
+
+struct KeccakMerkleTreeStruct {
+    uint64_t dataByteLen;
+    uint32_t leafByteLen;
+
+    // Level 0 holds the leaf hashes and the last level the root, all in one array
+    uint32_t nrLevels;
+    uint64_t * levelSizes;
+    uint64_t * levelOffsets;        // In nodes
+    uint8_t * nodes;
+
+    // The dirty leaves, in the order they were marked, without repeats
+    uint8_t * dirty;                // One flag per leaf
+    uint64_t * dirtyIndices;
+    uint64_t nrDirty;
+};
+
+typedef struct {
+    const KeccakMerkleTree * tree;
+    const uint8_t * data;
+    uint32_t level;
+    const uint64_t * indices;
+    uint64_t nrIndices;
+    uint64_t indicesPerTask;
+} MerkleJob;
+
+static uint8_t * Node(const KeccakMerkleTree * tree, uint32_t level, uint64_t index)
+{
+    return tree->nodes + (tree->levelOffsets[level] + index) * KeccakMerkleTreeNodeByteLen;
+}
+
+static void HashNodes(void * context, uint64_t task)
+{
+    const MerkleJob * job = context;
+    const KeccakMerkleTree * tree = job->tree;
+    const uint8_t leafPrefix = MerkleLeafPrefix;
+    SpongeState state;
+    SpongeMatrix matrix;
+    uint8_t nodeInput[MerkleNodeInputByteLen];
+
+    uint64_t i = task * job->indicesPerTask;
+    uint64_t last = i + job->indicesPerTask;
+    if (last > job->nrIndices) {
+        last = job->nrIndices;
+    }
+
+    for(; i < last; i++) {
+        uint64_t index = job->indices[i];
+
+        if (job->level == 0) {
+            uint64_t offset = index * tree->leafByteLen;
+            uint64_t length = tree->dataByteLen - offset;
+            if (length > tree->leafByteLen) {
+                length = tree->leafByteLen;
+            }
+
+            InitSHA3(&state, 256);
+            AbsorbBytes(&state, &leafPrefix, 1);
+            AbsorbBytes(&state, job->data + offset, length);
+            Squeeze(&state, Node(tree, 0, index), KeccakMerkleTreeNodeByteLen * 8);
+        }
+        else if (2 * index + 1 < tree->levelSizes[job->level - 1]) {
+            // The two children are adjacent in the level below; the node input fits in one block
+            nodeInput[0] = MerkleNodePrefix;
+            memcpy(nodeInput + 1, Node(tree, job->level - 1, 2 * index), 2 * KeccakMerkleTreeNodeByteLen);
+            SpongeOneShot(matrix, MerkleSHA3_256Rate, SHA3DelimitedSuffix, nodeInput, MerkleNodeInputByteLen,
+                          Node(tree, job->level, index), KeccakMerkleTreeNodeByteLen);
+        }
+        else {
+            // A lone last child is carried up
+            memcpy(Node(tree, job->level, index), Node(tree, job->level - 1, 2 * index), KeccakMerkleTreeNodeByteLen);
+        }
+    }
+
+    EraseState(&state);
+    KeccakErase(&matrix, sizeof(matrix)); // Clear memory of secret data
+    KeccakErase(nodeInput, sizeof(nodeInput));
+}
+
+static int CompareIndices(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+KeccakMerkleTree * KeccakMerkleTreeCreate(uint64_t dataByteLen, uint32_t leafByteLen)
+{
+    if (leafByteLen == 0) {
+        return NULL;
+    }
+
+    KeccakMerkleTree * tree = calloc(1, sizeof(KeccakMerkleTree));
+    if (tree == NULL) {
+        return NULL;
+    }
+
+    tree->dataByteLen = dataByteLen;
+    tree->leafByteLen = leafByteLen;
+
+    uint64_t nrLeaves = (dataByteLen == 0) ? 1 : (dataByteLen + leafByteLen - 1) / leafByteLen;
+    uint64_t nrNodes = 0;
+    uint64_t size;
+
+    // Count the levels and the nodes of all levels
+    tree->nrLevels = 1;
+    for(size = nrLeaves; size > 1; size = (size + 1) / 2) {
+        tree->nrLevels++;
+    }
+
+    tree->levelSizes = malloc(tree->nrLevels * sizeof(uint64_t));
+    tree->levelOffsets = malloc(tree->nrLevels * sizeof(uint64_t));
+    tree->dirty = calloc(nrLeaves, 1);
+    tree->dirtyIndices = malloc(nrLeaves * sizeof(uint64_t));
+
+    if ((tree->levelSizes == NULL) || (tree->levelOffsets == NULL) || (tree->dirty == NULL) || (tree->dirtyIndices == NULL)) {
+        KeccakMerkleTreeDestroy(tree);
+        return NULL;
+    }
+
+    uint32_t level;
+    for(level = 0, size = nrLeaves; level < tree->nrLevels; level++, size = (size + 1) / 2) {
+        tree->levelSizes[level] = size;
+        tree->levelOffsets[level] = nrNodes;
+        nrNodes += size;
+    }
+
+    tree->nodes = malloc(nrNodes * KeccakMerkleTreeNodeByteLen);
+    if (tree->nodes == NULL) {
+        KeccakMerkleTreeDestroy(tree);
+        return NULL;
+    }
+
+    KeccakMerkleTreeMarkDirty(tree, 0, (dataByteLen == 0) ? 1 : dataByteLen);
+
+    return tree;
+}
+
+void KeccakMerkleTreeMarkDirty(KeccakMerkleTree * tree, uint64_t offset, uint64_t length)
+{
+    uint64_t nrLeaves = tree->levelSizes[0];
+
+    if ((length == 0) || (offset / tree->leafByteLen >= nrLeaves)) {
+        return;
+    }
+
+    uint64_t leaf = offset / tree->leafByteLen;
+    uint64_t lastLeaf = (length - 1 > UINT64_MAX - offset) ? nrLeaves - 1 : (offset + length - 1) / tree->leafByteLen;
+    if (lastLeaf >= nrLeaves) {
+        lastLeaf = nrLeaves - 1;
+    }
+
+    for(; leaf <= lastLeaf; leaf++) {
+        if (!tree->dirty[leaf]) {
+            tree->dirty[leaf] = 1;
+            tree->dirtyIndices[tree->nrDirty++] = leaf;
+        }
+    }
+}
+
+void KeccakMerkleTreeUpdate(KeccakMerkleTree * tree, const uint8_t * data, KeccakThreadPool * pool)
+{
+    MerkleJob job;
+    uint64_t * indices = tree->dirtyIndices;
+    uint64_t nrIndices = tree->nrDirty;
+    uint64_t i;
+
+    if (nrIndices == 0) {
+        return;
+    }
+
+    // In order, so that the parents of each level come out sorted and without repeats
+    qsort(indices, nrIndices, sizeof(uint64_t), CompareIndices);
+
+    for(i = 0; i < nrIndices; i++) {
+        tree->dirty[indices[i]] = 0;
+    }
+
+    job.tree = tree;
+    job.data = data;
+
+    for(job.level = 0; job.level < tree->nrLevels; job.level++) {
+        if (job.level > 0) {
+            // The parents of the nodes hashed on the level below, in place
+            uint64_t nrParents = 0;
+            for(i = 0; i < nrIndices; i++) {
+                if ((nrParents == 0) || (indices[nrParents - 1] != indices[i] / 2)) {
+                    indices[nrParents++] = indices[i] / 2;
+                }
+            }
+            nrIndices = nrParents;
+        }
+
+        job.indices = indices;
+        job.nrIndices = nrIndices;
+
+        // Leaves are split by their size in bytes, interior nodes read 64 bytes each
+        uint64_t bytesPerIndex = (job.level == 0) ? tree->leafByteLen : 2 * KeccakMerkleTreeNodeByteLen;
+        job.indicesPerTask = (MerkleTaskBytes + bytesPerIndex - 1) / bytesPerIndex;
+
+        KeccakThreadPoolRun(pool, HashNodes, &job, (nrIndices + job.indicesPerTask - 1) / job.indicesPerTask);
+    }
+
+    tree->nrDirty = 0;
+}
+
+void KeccakMerkleTreeRoot(const KeccakMerkleTree * tree, uint8_t * root)
+{
+    memcpy(root, Node(tree, tree->nrLevels - 1, 0), KeccakMerkleTreeNodeByteLen);
+}
+
+uint64_t KeccakMerkleTreeLeafCount(const KeccakMerkleTree * tree)
+{
+    return tree->levelSizes[0];
+}
+
+void KeccakMerkleTreeDestroy(KeccakMerkleTree * tree)
+{
+    if (tree == NULL) {
+        return;
+    }
+
+    free(tree->nodes);
+    free(tree->dirtyIndices);
+    free(tree->dirty);
+    free(tree->levelOffsets);
+    free(tree->levelSizes);
+    free(tree);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+#include "KeccakThreadPool.h"
+
+/*
+ * Incremental Merkle tree over a fixed-size blob
+ *
+ * The blob is cut into leaves of a fixed size (the last may be shorter) and
+ * every node is a SHA3-256 hash, with a prefix byte separating the two kinds:
+ *   leaf i:  SHA3-256(00 || L_i)
+ *   node:    SHA3-256(01 || left || right)
+ * A node without a right sibling at the end of a level is carried up unchanged.
+ *
+ * Every level is kept in memory, 32 bytes per node, so after leaves are marked
+ * dirty only those leaves and the nodes on their paths to the root are hashed
+ * again: the cost follows the size of the change, not the size of the blob.
+ */
+
+#define KeccakMerkleTreeNodeByteLen 32
+
+typedef struct KeccakMerkleTreeStruct KeccakMerkleTree;
+
+/**
+  * Create a tree for a blob of @a dataByteLen bytes, with every leaf dirty.
+  * @param  dataByteLen The size of the blob in bytes, may be 0 (a single empty leaf).
+  * @param  leafByteLen The size of a leaf in bytes, greater than 0, e.g. 4096.
+  * @return Pointer to the new tree, or NULL if memory could not be allocated.
+  */
+KeccakMerkleTree * KeccakMerkleTreeCreate(uint64_t dataByteLen, uint32_t leafByteLen);
+
+/**
+  * Mark the leaves covering bytes @a offset to @a offset + @a length - 1 as changed.
+  * Bytes past the end of the blob are ignored.
+  * @param  tree        Pointer to the tree.
+  * @param  offset      The offset of the first changed byte.
+  * @param  length      The number of changed bytes.
+  */
+void KeccakMerkleTreeMarkDirty(KeccakMerkleTree * tree, uint64_t offset, uint64_t length);
+
+/**
+  * Hash the dirty leaves and the nodes on their paths to the root again.
+  * @param  tree        Pointer to the tree.
+  * @param  data        Pointer to the current contents of the whole blob.
+  * @param  pool        Thread pool hashing the nodes of each level, or NULL to hash them in the calling thread.
+  */
+void KeccakMerkleTreeUpdate(KeccakMerkleTree * tree, const uint8_t * data, KeccakThreadPool * pool);
+
+/**
+  * Get the root hash as of the last KeccakMerkleTreeUpdate().
+  * @param  tree        Pointer to the tree.
+  * @param  root        Pointer to the buffer where to store the KeccakMerkleTreeNodeByteLen bytes of the root.
+  */
+void KeccakMerkleTreeRoot(const KeccakMerkleTree * tree, uint8_t * root);
+
+/**
+  * Get the number of leaves of the tree.
+  * @param  tree        Pointer to the tree.
+  */
+uint64_t KeccakMerkleTreeLeafCount(const KeccakMerkleTree * tree);
+
+/**
+  * Free the tree.
+  * @param  tree        Pointer to the tree created by KeccakMerkleTreeCreate(), or NULL.
+  */
+void KeccakMerkleTreeDestroy(KeccakMerkleTree * tree);
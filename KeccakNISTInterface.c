@@ -7,6 +7,8 @@
 
 #include "KeccakNISTInterface.h"
 #include "KeccakSponge.h"
+#include "KeccakErase.h"
+#include "KeccakF-1600-times.h"
 
 HashReturn Init(HashState * state, uint32_t hashBitLen)
 {
@@ -40,10 +42,10 @@ HashReturn Init(HashState * state, uint32_t hashBitLen)
 HashReturn Update(HashState * state, const BitSequence * data, DataLength dataBitLen)
 {
     if ((dataBitLen % 8) == 0) {
-        return Absorb(state, data, dataBitLen);
+        return AbsorbBytes(state, data, dataBitLen / 8);
     }
     else {
-        HashReturn returnVal = Absorb(state, data, dataBitLen - (dataBitLen % 8));
+        HashReturn returnVal = AbsorbBytes(state, data, dataBitLen / 8);
 
         if (returnVal == SUCCESS) {
             // Align the last partial byte to the least significant bits
@@ -51,7 +53,7 @@ HashReturn Update(HashState * state, const BitSequence * data, DataLength dataBi
 
             returnVal = Absorb(state, &lastByte, dataBitLen % 8);
 
-            memset(&lastByte, 0, sizeof(lastByte)); // Clear memory of secret data
+            KeccakErase(&lastByte, sizeof(lastByte)); // Clear memory of secret data
 
             return returnVal;
         }
@@ -66,6 +68,19 @@ HashReturn Final(HashState * state, BitSequence * hashVal)
     return Squeeze(state, hashVal, state->fixedOutputLength);
 }
 
+static uint32_t RateForHashBitLen(uint32_t hashBitLen)
+{
+    switch(hashBitLen) {
+        case 224:
+        case 256:
+        case 384:
+        case 512:
+            return 1600 - 2 * hashBitLen; // Capacity is twice the output length
+        default:
+            return 0;
+    }
+}
+
 HashReturn Hash(uint32_t hashBitLen, const BitSequence * data, DataLength databitlen, BitSequence * hashVal)
 {
     HashState state;
@@ -75,6 +90,18 @@ HashReturn Hash(uint32_t hashBitLen, const BitSequence * data, DataLength databi
         return BAD_HASHLEN; // Only the four fixed output lengths available through this API
     }
 
+    // Byte-aligned messages go straight to the sponge loops specialized for the rate
+    uint32_t rate = RateForHashBitLen(hashBitLen);
+    if ((rate != 0) && ((databitlen % 8) == 0)) {
+        SpongeMatrix matrix;
+
+        SpongeOneShot(matrix, rate, KeccakDelimitedSuffix, data, databitlen / 8, hashVal, hashBitLen / 8);
+
+        KeccakErase(&matrix, sizeof(matrix)); // Clear memory of secret data
+        KeccakEraseStack();
+        return SUCCESS;
+    }
+
     returnVal = Init(&state, hashBitLen);
 
     if (returnVal != SUCCESS) {
@@ -94,3 +121,91 @@ HashReturn Hash(uint32_t hashBitLen, const BitSequence * data, DataLength databi
     return returnVal;
 }
 
+
+/*
+ * Batch hashing
+ */
+HashReturn HashBatch(uint32_t hashBitLen, const HashBatchEntry * entries, size_t count)
+{
+    uint32_t rate = RateForHashBitLen(hashBitLen);
+    HashReturn returnVal = SUCCESS;
+    SpongeMatrix matrix;
+    HashState state;
+    int32_t stateInitialized = 0;
+
+    if (rate == 0) {
+        return BAD_HASHLEN;
+    }
+
+    size_t i;
+    for(i = 0; (i < count) && (returnVal == SUCCESS); i++) {
+        const HashBatchEntry * entry = &entries[i];
+
+        if ((entry->dataBitLen % 8) == 0) {
+            uint64_t dataByteLen = entry->dataBitLen / 8;
+
+            SpongeOneShot(matrix, rate, KeccakDelimitedSuffix, entry->data, dataByteLen,
+                          entry->hashVal, hashBitLen/8);
+        }
+        else {
+            // Partial final byte: use the bit-level sponge, set up once for the batch
+            if (!stateInitialized) {
+                Init(&state, hashBitLen);
+                stateInitialized = 1;
+            }
+            else {
+                ResetSponge(&state);
+            }
+
+            returnVal = Update(&state, entry->data, entry->dataBitLen);
+
+            if (returnVal == SUCCESS) {
+                returnVal = Final(&state, entry->hashVal);
+            }
+        }
+    }
+
+    KeccakErase(&matrix, sizeof(matrix)); // Clear memory of secret data
+    if (stateInitialized) {
+        EraseState(&state);
+    }
+    KeccakEraseStack();
+
+    return returnVal;
+}
+
+HashReturn HashBatchFixed(uint32_t hashBitLen, const BitSequence * data, DataLength dataBitLen,
+                          size_t count, BitSequence * hashVals)
+{
+    uint32_t rate = RateForHashBitLen(hashBitLen);
+    SpongeMatrix matrices[KeccakMaxParallelism];
+
+    if (rate == 0) {
+        return BAD_HASHLEN;
+    }
+    if ((dataBitLen % 8) != 0) {
+        return FAIL; // Use HashBatch() for messages with a partial byte
+    }
+
+    uint64_t dataByteLen = dataBitLen / 8;
+
+    // Groups of messages share their permutations, the remainder is hashed one at a time
+    size_t i = 0;
+    for(; i + KeccakMaxParallelism <= count; i += KeccakMaxParallelism) {
+        SpongeOneShotTimes8(matrices, rate, KeccakDelimitedSuffix, data, dataByteLen, hashVals, hashBitLen/8);
+
+        data += KeccakMaxParallelism * dataByteLen;
+        hashVals += KeccakMaxParallelism * hashBitLen/8;
+    }
+    for(; i < count; i++) {
+        SpongeOneShot(matrices[0], rate, KeccakDelimitedSuffix, data, dataByteLen, hashVals, hashBitLen/8);
+
+        data += dataByteLen;
+        hashVals += hashBitLen/8;
+    }
+
+    KeccakErase(&matrices, sizeof(matrices)); // Clear memory of secret data
+    KeccakEraseStack();
+
+    return SUCCESS;
+}
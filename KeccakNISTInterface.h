@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "KeccakSponge.h"
@@ -14,6 +15,15 @@ typedef uint64_t DataLength;
 typedef SpongeReturn HashReturn;
 typedef SpongeState HashState;
 
+/**
+  * One message of a batch passed to HashBatch().
+  */
+typedef struct {
+    const BitSequence * data;       // Pointer to the input data, as for Hash()
+    DataLength dataBitLen;          // The number of input bits provided in the input data
+    BitSequence * hashVal;          // Pointer to the buffer where to store the output data
+} HashBatchEntry;
+
 /**
   * Function to initialize the state of the Keccak[r, c] sponge function.
   * The rate r and capacity c values are determined from @a hashBitLen.
@@ -59,5 +69,38 @@ HashReturn Final(HashState * state, BitSequence * hashVal);
   * @param  hashVal     Pointer to the buffer where to store the output data.
   * @pre    The value of hashBitLen must be one of 224, 256, 384 and 512.
   * @return SUCCESS if successful, BAD_HASHLEN if the value of hashBitLen is incorrect.
+  * Byte-aligned messages are hashed with SpongeOneShot(), on the loops specialized for the rate.
   */
 HashReturn Hash(uint32_t hashBitLen, const BitSequence * data, DataLength dataBitLen, BitSequence * hashVal);
+
+/**
+  * Function to compute the hashes of many independent messages with one output length.
+  * The output length is validated and the sponge parameters derived once for the batch.
+  * Byte-aligned messages are hashed with SpongeOneShot() without a HashState,
+  * other messages go through a single HashState that is reset between messages.
+  * @param  hashBitLen  The desired number of output bits for every message.
+  * @param  entries     Array of (data, dataBitLen, hashVal) triples, see Hash().
+  * @param  count       The number of entries.
+  * @pre    The value of hashBitLen must be one of 224, 256, 384 and 512.
+  * @return SUCCESS if successful, BAD_HASHLEN if the value of hashBitLen is incorrect.
+  */
+HashReturn HashBatch(uint32_t hashBitLen, const HashBatchEntry * entries, size_t count);
+
+/**
+  * Function to compute the hashes of many messages that all have the same length.
+  * The messages are stored back to back in @a data and the outputs are written back
+  * to back to @a hashVals. Groups of eight messages are hashed in lock-step with
+  * SpongeOneShotTimes8(). Messages shorter than a block, such as 32-byte keys or
+  * 64-byte Merkle node pairs, cost one 8-way permutation per group and are loaded
+  * and written a lane at a time.
+  * @param  hashBitLen  The desired number of output bits for every message.
+  * @param  data        Pointer to @a count messages of @a dataBitLen bits each.
+  * @param  dataBitLen  The number of bits in each message, a multiple of 8.
+  * @param  count       The number of messages.
+  * @param  hashVals    Pointer to a buffer of @a count * @a hashBitLen / 8 bytes.
+  * @pre    The value of hashBitLen must be one of 224, 256, 384 and 512.
+  * @return SUCCESS if successful, BAD_HASHLEN if the value of hashBitLen is incorrect,
+  *         FAIL if dataBitLen is not a multiple of 8.
+  */
+HashReturn HashBatchFixed(uint32_t hashBitLen, const BitSequence * data, DataLength dataBitLen,
+                          size_t count, BitSequence * hashVals);
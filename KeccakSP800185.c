@@ -0,0 +1,261 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "KeccakSponge.h"
+#include "KeccakErase.h"
+#include "KeccakFIPS202.h"
+#include "KeccakSP800185.h"
+
+/*
+ * Encodings
+ */
+uint32_t SP800185LeftEncode(uint8_t * encoding, uint64_t value)
+{
+    uint32_t n = 1;
+    while((n < 8) && ((value >> (8 * n)) != 0)) {
+        n++;
+    }
+
+    encoding[0] = (uint8_t) n;
+
+    uint32_t i;
+    for(i = 1; i <= n; i++) {
+        encoding[i] = (uint8_t) (value >> (8 * (n - i)));
+    }
+    return n + 1;
+}
+
+uint32_t SP800185RightEncode(uint8_t * encoding, uint64_t value)
+{
+    uint32_t n = 1;
+    while((n < 8) && ((value >> (8 * n)) != 0)) {
+        n++;
+    }
+
+    uint32_t i;
+    for(i = 0; i < n; i++) {
+        encoding[i] = (uint8_t) (value >> (8 * (n - 1 - i)));
+    }
+
+    encoding[n] = (uint8_t) n;
+    return n + 1;
+}
+
+/**
+  * Absorb encode_string(X) = left_encode(|X| in bits) || X and return the number of bytes absorbed.
+  */
+static uint64_t AbsorbEncodedString(SpongeState * state, const uint8_t * data, uint64_t dataByteLen)
+{
+    uint8_t encoding[9];
+    uint32_t encodingLength = SP800185LeftEncode(encoding, dataByteLen * 8);
+
+    AbsorbBytes(state, encoding, encodingLength);
+    AbsorbBytes(state, data, dataByteLen);
+
+    return encodingLength + dataByteLen;
+}
+
+/**
+  * Absorb left_encode(r/8), the start of bytepad(X, r/8), and return the number of bytes absorbed.
+  */
+static uint64_t AbsorbBytepadStart(SpongeState * state)
+{
+    uint8_t encoding[9];
+    uint32_t encodingLength = SP800185LeftEncode(encoding, state->rate/8);
+
+    AbsorbBytes(state, encoding, encodingLength);
+
+    return encodingLength;
+}
+
+/**
+  * Zero-pad bytepad(X, r/8) to a whole number of blocks, after @a absorbed bytes of it.
+  */
+static void AbsorbBytepadEnd(SpongeState * state, uint64_t absorbed)
+{
+    static const uint8_t zeros[KeccakMaximumRateInBytes] = {0};
+
+    AbsorbBytes(state, zeros, (state->rate/8 - (absorbed % (state->rate/8))) % (state->rate/8));
+}
+
+/**
+  * Absorb right_encode(@a value).
+  * @return SpongeReturn of AbsorbBytes(), MODE_IS_SQUEEZING if the sponge is already squeezing.
+  */
+static SpongeReturn AbsorbRightEncoded(SpongeState * state, uint64_t value)
+{
+    uint8_t encoding[9];
+    uint32_t encodingLength = SP800185RightEncode(encoding, value);
+
+    return AbsorbBytes(state, encoding, encodingLength);
+}
+
+/*
+ * cSHAKE
+ */
+SpongeReturn InitcSHAKE(SpongeState * state, uint32_t securityStrength,
+                        const uint8_t * name, uint64_t nameByteLen,
+                        const uint8_t * customization, uint64_t customizationByteLen)
+{
+    SpongeReturn returnVal = InitSHAKE(state, securityStrength);
+
+    // With N and S both empty, cSHAKE is SHAKE
+    if ((returnVal != SUCCESS) || ((nameByteLen == 0) && (customizationByteLen == 0))) {
+        return returnVal;
+    }
+
+    uint64_t absorbed = AbsorbBytepadStart(state);
+    absorbed += AbsorbEncodedString(state, name, nameByteLen);
+    absorbed += AbsorbEncodedString(state, customization, customizationByteLen);
+    AbsorbBytepadEnd(state, absorbed);
+
+    state->delimitedSuffix = cSHAKEDelimitedSuffix;
+
+    return SUCCESS;
+}
+
+SpongeReturn cSHAKE(uint32_t securityStrength, const uint8_t * data, uint64_t dataByteLen,
+                    const uint8_t * name, uint64_t nameByteLen,
+                    const uint8_t * customization, uint64_t customizationByteLen,
+                    uint8_t * output, uint64_t outputBitLen)
+{
+    SpongeState state;
+    SpongeReturn returnVal;
+
+    if ((outputBitLen % 8) != 0) {
+        return BAD_HASHLEN;
+    }
+
+    returnVal = InitcSHAKE(&state, securityStrength, name, nameByteLen, customization, customizationByteLen);
+
+    if (returnVal == SUCCESS) {
+        AbsorbBytes(&state, data, dataByteLen);
+        returnVal = Squeeze(&state, output, outputBitLen);
+    }
+
+    EraseState(&state);
+
+    return returnVal;
+}
+
+/*
+ * KMAC
+ */
+SpongeReturn InitKMAC(SpongeState * state, uint32_t securityStrength,
+                      const uint8_t * key, uint64_t keyByteLen,
+                      const uint8_t * customization, uint64_t customizationByteLen)
+{
+    static const uint8_t functionName[] = "KMAC";
+    SpongeReturn returnVal;
+
+    returnVal = InitcSHAKE(state, securityStrength, functionName, sizeof(functionName) - 1,
+                           customization, customizationByteLen);
+
+    if (returnVal == SUCCESS) {
+        uint64_t absorbed = AbsorbBytepadStart(state);
+        absorbed += AbsorbEncodedString(state, key, keyByteLen);
+        AbsorbBytepadEnd(state, absorbed);
+    }
+
+    return returnVal;
+}
+
+// The state holds the key, so it is erased whatever the erasure policy
+void EraseKMAC(SpongeState * state)
+{
+    KeccakSecureErase(state, sizeof(SpongeState));
+    KeccakSecureEraseStack();
+}
+
+SpongeReturn FinalKMAC(SpongeState * state, uint8_t * output, uint64_t outputBitLen, int32_t xof)
+{
+    if ((outputBitLen % 8) != 0) {
+        return BAD_HASHLEN;
+    }
+
+    SpongeReturn returnVal = AbsorbRightEncoded(state, xof ? 0 : outputBitLen);
+
+    if (returnVal == SUCCESS) {
+        returnVal = Squeeze(state, output, outputBitLen);
+    }
+
+    return returnVal;
+}
+
+SpongeReturn KMACFromKeyState(const SpongeState * keyState, const uint8_t * data, uint64_t dataByteLen,
+                              uint8_t * output, uint64_t outputBitLen, int32_t xof)
+{
+    SpongeState state;
+    SpongeReturn returnVal;
+
+    CloneSponge(&state, keyState);
+
+    returnVal = AbsorbBytes(&state, data, dataByteLen);
+
+    if (returnVal == SUCCESS) {
+        returnVal = FinalKMAC(&state, output, outputBitLen, xof);
+    }
+
+    EraseKMAC(&state);
+
+    return returnVal;
+}
+
+SpongeReturn KMAC(uint32_t securityStrength, const uint8_t * key, uint64_t keyByteLen,
+                  const uint8_t * data, uint64_t dataByteLen,
+                  const uint8_t * customization, uint64_t customizationByteLen,
+                  uint8_t * output, uint64_t outputBitLen, int32_t xof)
+{
+    SpongeState state;
+    SpongeReturn returnVal;
+
+    returnVal = InitKMAC(&state, securityStrength, key, keyByteLen, customization, customizationByteLen);
+
+    if (returnVal == SUCCESS) {
+        AbsorbBytes(&state, data, dataByteLen);
+        returnVal = FinalKMAC(&state, output, outputBitLen, xof);
+    }
+
+    EraseKMAC(&state);
+
+    return returnVal;
+}
+
+/*
+ * TupleHash
+ */
+SpongeReturn TupleHash(uint32_t securityStrength, const SP800185String * tuple, uint32_t tupleLength,
+                       const uint8_t * customization, uint64_t customizationByteLen,
+                       uint8_t * output, uint64_t outputBitLen, int32_t xof)
+{
+    static const uint8_t functionName[] = "TupleHash";
+    SpongeState state;
+    SpongeReturn returnVal;
+
+    if ((outputBitLen % 8) != 0) {
+        return BAD_HASHLEN;
+    }
+
+    returnVal = InitcSHAKE(&state, securityStrength, functionName, sizeof(functionName) - 1,
+                           customization, customizationByteLen);
+
+    if (returnVal == SUCCESS) {
+        uint32_t i;
+        for(i = 0; i < tupleLength; i++) {
+            AbsorbEncodedString(&state, tuple[i].data, tuple[i].byteLen);
+        }
+
+        returnVal = AbsorbRightEncoded(&state, xof ? 0 : outputBitLen);
+        if (returnVal == SUCCESS) {
+            returnVal = Squeeze(&state, output, outputBitLen);
+        }
+    }
+
+    EraseState(&state);
+
+    return returnVal;
+}
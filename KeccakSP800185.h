@@ -0,0 +1,179 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+
+/*
+ * NIST SP 800-185: cSHAKE, KMAC and TupleHash
+ *
+ *   cSHAKE(X, L, N, S) = Keccak[2s](bytepad(encode_string(N) || encode_string(S), r) || X || 00, L)
+ *                        or SHAKE(X, L) when N and S are both empty
+ *   KMAC(K, X, L, S)   = cSHAKE(bytepad(encode_string(K), r) || X || right_encode(L), L, "KMAC", S)
+ *   TupleHash(X, L, S) = cSHAKE(encode_string(X_1) || ... || encode_string(X_n) || right_encode(L), L, "TupleHash", S)
+ * where s is the security strength and r the rate. The XOF variants encode L as 0.
+ *
+ * Everything is absorbed straight into a SpongeState, without building the
+ * concatenations in memory. InitKMAC() absorbs the key once; CloneSponge() of
+ * that state and KMACFromKeyState() then cost one or two permutations per
+ * short message.
+ */
+
+/*
+ * A byte string, e.g. one element of a TupleHash tuple
+ */
+typedef struct {
+    const uint8_t * data;
+    uint64_t byteLen;
+} SP800185String;
+
+/**
+  * Write left_encode(@a value): the number of bytes n, then @a value in n big-endian bytes.
+  * @param  encoding    Pointer to a buffer of at least 9 bytes.
+  * @param  value       The value to encode.
+  * @return The number of bytes written.
+  */
+uint32_t SP800185LeftEncode(uint8_t * encoding, uint64_t value);
+
+/**
+  * Write right_encode(@a value): @a value in n big-endian bytes, then n.
+  * @param  encoding    Pointer to a buffer of at least 9 bytes.
+  * @param  value       The value to encode.
+  * @return The number of bytes written.
+  */
+uint32_t SP800185RightEncode(uint8_t * encoding, uint64_t value);
+
+/**
+  * Initialize a sponge for cSHAKE128 or cSHAKE256 and absorb its prefix.
+  * The input is then given with AbsorbBytes() and the output read with Squeeze().
+  * @param  state       Pointer to the state of the sponge function to be initialized.
+  * @param  securityStrength    128 or 256.
+  * @param  name        Pointer to the function name N.
+  * @param  nameByteLen The number of bytes in N, may be 0.
+  * @param  customization   Pointer to the customization string S.
+  * @param  customizationByteLen    The number of bytes in S, may be 0.
+  * @return SpongeReturn
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         SUCCESS           - Sponge initialized
+  */
+SpongeReturn InitcSHAKE(SpongeState * state, uint32_t securityStrength,
+                        const uint8_t * name, uint64_t nameByteLen,
+                        const uint8_t * customization, uint64_t customizationByteLen);
+
+/**
+  * Compute cSHAKE128 or cSHAKE256 of a byte-aligned message.
+  * @param  securityStrength    128 or 256.
+  * @param  data        Pointer to the input data X.
+  * @param  dataByteLen The number of input bytes.
+  * @param  name        Pointer to the function name N.
+  * @param  nameByteLen The number of bytes in N, may be 0.
+  * @param  customization   Pointer to the customization string S.
+  * @param  customizationByteLen    The number of bytes in S, may be 0.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits L, a multiple of 8.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The output length is not a multiple of 8 bits.
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         SUCCESS     - The output was computed.
+  */
+SpongeReturn cSHAKE(uint32_t securityStrength, const uint8_t * data, uint64_t dataByteLen,
+                    const uint8_t * name, uint64_t nameByteLen,
+                    const uint8_t * customization, uint64_t customizationByteLen,
+                    uint8_t * output, uint64_t outputBitLen);
+
+/**
+  * Initialize a sponge for KMAC128 or KMAC256 and absorb the key.
+  * Keep the result as the key state: the message of each MAC is absorbed into a
+  * CloneSponge() of it, or given to KMACFromKeyState(). The key state, and any
+  * clone of it, holds the key: wipe it with EraseKMAC(), which clears it under
+  * every erasure policy, unlike EraseState().
+  * @param  state       Pointer to the state of the sponge function to be initialized.
+  * @param  securityStrength    128 or 256.
+  * @param  key         Pointer to the key K.
+  * @param  keyByteLen  The number of bytes in K.
+  * @param  customization   Pointer to the customization string S.
+  * @param  customizationByteLen    The number of bytes in S, may be 0.
+  * @return SpongeReturn
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         SUCCESS           - Sponge initialized
+  */
+SpongeReturn InitKMAC(SpongeState * state, uint32_t securityStrength,
+                      const uint8_t * key, uint64_t keyByteLen,
+                      const uint8_t * customization, uint64_t customizationByteLen);
+
+/**
+  * Clear a KMAC key state, or a clone of it, whatever the erasure policy of KeccakErase.h.
+  * @param  state       Pointer to the state from InitKMAC() or a CloneSponge() of it.
+  */
+void EraseKMAC(SpongeState * state);
+
+/**
+  * Finish a KMAC whose message has been absorbed: absorb right_encode(L) and squeeze.
+  * @param  state       Pointer to the state from InitKMAC() that absorbed the message.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits L, a multiple of 8.
+  * @param  xof         1 for KMACXOF (L is not bound into the output), 0 otherwise.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The output length is not a multiple of 8 bits.
+  *         MODE_IS_SQUEEZING - The state was already finished; nothing is output.
+  *         SUCCESS     - The output was computed.
+  */
+SpongeReturn FinalKMAC(SpongeState * state, uint8_t * output, uint64_t outputBitLen, int32_t xof);
+
+/**
+  * Compute the KMAC of a message from a key state, which is left unchanged.
+  * @param  keyState    Pointer to the state initialized by InitKMAC().
+  * @param  data        Pointer to the input data X.
+  * @param  dataByteLen The number of input bytes.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits L, a multiple of 8.
+  * @param  xof         1 for KMACXOF, 0 otherwise.
+  * @return SpongeReturn, see FinalKMAC().
+  */
+SpongeReturn KMACFromKeyState(const SpongeState * keyState, const uint8_t * data, uint64_t dataByteLen,
+                              uint8_t * output, uint64_t outputBitLen, int32_t xof);
+
+/**
+  * Compute KMAC128 or KMAC256 of a byte-aligned message.
+  * @param  securityStrength    128 or 256.
+  * @param  key         Pointer to the key K.
+  * @param  keyByteLen  The number of bytes in K.
+  * @param  data        Pointer to the input data X.
+  * @param  dataByteLen The number of input bytes.
+  * @param  customization   Pointer to the customization string S.
+  * @param  customizationByteLen    The number of bytes in S, may be 0.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits L, a multiple of 8.
+  * @param  xof         1 for KMACXOF, 0 otherwise.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The output length is not a multiple of 8 bits.
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         SUCCESS     - The output was computed.
+  */
+SpongeReturn KMAC(uint32_t securityStrength, const uint8_t * key, uint64_t keyByteLen,
+                  const uint8_t * data, uint64_t dataByteLen,
+                  const uint8_t * customization, uint64_t customizationByteLen,
+                  uint8_t * output, uint64_t outputBitLen, int32_t xof);
+
+/**
+  * Compute TupleHash128 or TupleHash256 of a tuple of byte strings.
+  * @param  securityStrength    128 or 256.
+  * @param  tuple       Pointer to the elements X_1 .. X_n.
+  * @param  tupleLength The number of elements n, may be 0.
+  * @param  customization   Pointer to the customization string S.
+  * @param  customizationByteLen    The number of bytes in S, may be 0.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits L, a multiple of 8.
+  * @param  xof         1 for TupleHashXOF, 0 otherwise.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The output length is not a multiple of 8 bits.
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         SUCCESS     - The output was computed.
+  */
+SpongeReturn TupleHash(uint32_t securityStrength, const SP800185String * tuple, uint32_t tupleLength,
+                       const uint8_t * customization, uint64_t customizationByteLen,
+                       uint8_t * output, uint64_t outputBitLen, int32_t xof);
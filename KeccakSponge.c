@@ -3,12 +3,113 @@
  */
 
 #include <stdint.h>
-#include <string.h>
 
 #include "KeccakSponge.h"
 #include "KeccakF-1600-reference.h"
+#include "KeccakF-1600-times.h"
+#include "KeccakInstrumentation.h"
+#include "KeccakErase.h"
+#include "KeccakSponge-rates.macros"
+
+/*
+ * Whole-block loops, specialized for the rates of SHA3, SHAKE and Keccak-n
+ */
+static void XorTailAndPadding(SpongeMatrix state, uint32_t rate, uint8_t delimitedSuffix,
+                              const uint8_t * data, uint32_t tailLength)
+{
+    // Keys, digests and Merkle nodes of 32 and 64 bytes are XORed a lane at a time
+    switch(tailLength) {
+        case 32:
+            forLanes4(XorLane, state, data)
+            break;
+        case 64:
+            forLanes8(XorLane, state, data)
+            break;
+        default:
+            KeccakXorBytesIntoState(state, data, 0, tailLength);
+    }
+
+    // The suffix bits with the first bit of the pad10*1, then its last bit
+    SpongeLane(state, tailLength / 8) ^= (uint64_t) delimitedSuffix << (8 * (tailLength % 8));
+    SpongeLane(state, (rate/8 - 1) / 8) ^= (uint64_t) 0x80 << (8 * ((rate/8 - 1) % 8));
+}
+
+/**
+  * Extract the first @a outputByteLen bytes of the state, 32- and 64-byte digests a lane at a time.
+  */
+static void ExtractOutputBytes(SpongeMatrix state, uint8_t * output, uint32_t outputByteLen)
+{
+    switch(outputByteLen) {
+        case 32:
+            forLanes4(ExtractLane, state, output)
+            break;
+        case 64:
+            forLanes8(ExtractLane, state, output)
+            break;
+        default:
+            KeccakExtractBytes(state, output, 0, outputByteLen);
+    }
+}
+
+DefineRateSpecializedSponge(576, 9)
+DefineRateSpecializedSponge(832, 13)
+DefineRateSpecializedSponge(1088, 17)
+DefineRateSpecializedSponge(1152, 18)
+DefineRateSpecializedSponge(1344, 21)
+
+/**
+  * Absorb the whole blocks at the start of the input.
+  * @return The number of bytes absorbed, a multiple of rate/8.
+  */
+static uint64_t AbsorbWholeBlocks(SpongeMatrix state, uint32_t rate, uint32_t rounds,
+                                  const uint8_t * data, uint64_t dataByteLen)
+{
+    switch(rate) {
+        case 576:  return AbsorbBlocks576(state, rounds, data, dataByteLen);
+        case 832:  return AbsorbBlocks832(state, rounds, data, dataByteLen);
+        case 1088: return AbsorbBlocks1088(state, rounds, data, dataByteLen);
+        case 1152: return AbsorbBlocks1152(state, rounds, data, dataByteLen);
+        case 1344: return AbsorbBlocks1344(state, rounds, data, dataByteLen);
+    }
+
+    uint64_t absorbed = 0;
+    while(dataByteLen - absorbed >= rate/8) {
+        KeccakAbsorbRounds(state, data + absorbed, rate, rounds);
+        absorbed += rate/8;
+    }
+    KeccakCount(fastPathBytes, absorbed);
+    KeccakCount(fastPathBlocks, absorbed / (rate/8));
+    return absorbed;
+}
+
+/**
+  * Permute the state and extract a block of output, @a blocks times.
+  */
+static void SqueezeWholeBlocks(SpongeMatrix state, uint32_t rate, uint32_t rounds,
+                               uint8_t * output, uint64_t blocks)
+{
+    switch(rate) {
+        case 576:  SqueezeBlocks576(state, rounds, output, blocks); return;
+        case 832:  SqueezeBlocks832(state, rounds, output, blocks); return;
+        case 1088: SqueezeBlocks1088(state, rounds, output, blocks); return;
+        case 1152: SqueezeBlocks1152(state, rounds, output, blocks); return;
+        case 1344: SqueezeBlocks1344(state, rounds, output, blocks); return;
+    }
+
+    while(blocks > 0) {
+        KeccakPermutationRounds(state, rounds);
+        KeccakExtract(state, output, rate);
+        output += rate/8;
+        blocks--;
+    }
+}
 
 SpongeReturn InitSponge(SpongeState * state, uint32_t rate, uint32_t capacity)
+{
+    return InitSpongeRounds(state, rate, capacity, nrRounds);
+}
+
+SpongeReturn InitSpongeRounds(SpongeState * state, uint32_t rate, uint32_t capacity, uint32_t rounds)
 {
     if (rate+capacity != 1600) {
         return BAD_RATE_CAPACITY;
@@ -16,124 +117,133 @@ SpongeReturn InitSponge(SpongeState * state, uint32_t rate, uint32_t capacity)
     if ((rate >= 1600) || ((rate % 64) != 0)) {
         return BAD_RATE_CAPACITY;
     }
+    if ((rounds == 0) || (rounds > nrRounds)) {
+        return BAD_ROUNDS;
+    }
 
     state->rate = rate;
-    state->capacity = capacity;
+    state->rounds = rounds;
+    state->delimitedSuffix = KeccakDelimitedSuffix;
     state->fixedOutputLength = 0;
     KeccakInitialize(state->state);
     
-    memset(state->dataQueue, 0, KeccakMaximumRateInBytes);
-    state->bitsInQueue = 0;
+    state->bitsInBlock = 0;
     state->mode = ABSORBING;
     state->bitsAvailableForSqueezing = 0;
 
     return SUCCESS;
 }
 
-SpongeReturn Absorb(SpongeState * state, const uint8_t * data, uint64_t dataBitLen)
+void ResetSponge(SpongeState * state)
 {
-    if ((state->bitsInQueue % 8) != 0) {
+    KeccakInitialize(state->state);
+    state->bitsInBlock = 0;
+    state->mode = ABSORBING;
+    state->bitsAvailableForSqueezing = 0;
+}
+
+void CloneSponge(SpongeState * destination, const SpongeState * source)
+{
+    *destination = *source;
+}
+
+SpongeReturn AbsorbBytes(SpongeState * state, const uint8_t * data, uint64_t dataByteLen)
+{
+    if ((state->bitsInBlock % 8) != 0) {
         return PARTIAL_BYTES_IN_MULTIPLE_ABSORBS; // Only the last call may contain a partial byte
     }
  
     if(state->mode == SQUEEZING) {
         return MODE_IS_SQUEEZING; // Too late for additional input
     }
+    if(state->mode == DUPLEXING) {
+        return BAD_MODE;
+    }
 
-    uint64_t bitsAbsorbed = 0;
+    uint32_t rateInBytes = state->rate / 8;
+    uint32_t offset = state->bitsInBlock / 8;
+    KeccakTimerStart(start);
 
-    while(bitsAbsorbed < dataBitLen) {
+    // Complete the open block
+    if (offset > 0) {
+        uint32_t length = (dataByteLen < rateInBytes - offset) ? (uint32_t) dataByteLen : rateInBytes - offset;
 
-        if ((state->bitsInQueue == 0) && (dataBitLen >= state->rate) && (bitsAbsorbed <= (dataBitLen - state->rate))) {
-            // If the data is at least a whole block and no data is waiting
-            
-            // How many whole blocks fit into the data
-            uint64_t wholeBlocks = (dataBitLen - bitsAbsorbed) / state->rate;
+        KeccakXorBytesIntoState(state->state, data, offset, length);
+        KeccakCount(partialBlockBytes, length);
+        data += length;
+        dataByteLen -= length;
+        offset += length;
 
-            // Pointer to the current offset
-            const uint8_t * curData = data + bitsAbsorbed/8;
-            uint64_t block;
+        if (offset < rateInBytes) {
+            state->bitsInBlock = offset * 8;
+            KeccakTimerStop(absorbNanoseconds, start);
+            return SUCCESS;
+        }
 
-            // Absorb blocks
-            for(block = 0; block < wholeBlocks; block++) {
-                KeccakAbsorb(state->state, curData, state->rate);
-                curData += state->rate/8;
-            }
+        KeccakPermutationRounds(state->state, state->rounds);
+    }
 
-            bitsAbsorbed += wholeBlocks * state->rate;
-        }
-        else {
-            // How much data is left to absorb
-            uint64_t partialBlock = dataBitLen - bitsAbsorbed;
-
-            // If the data left to absorb and the data in queue is greater than the rate,
-            // process only as much new data as will fit after the data in queue.
-            if (partialBlock + state->bitsInQueue > state->rate) {
-                partialBlock = state->rate - state->bitsInQueue;
-            }
+    // Whole blocks straight from the input
+    uint64_t absorbed = AbsorbWholeBlocks(state->state, state->rate, state->rounds, data, dataByteLen);
+    data += absorbed;
+    dataByteLen -= absorbed;
 
-            // Truncate to byte-align the new data length
-            uint64_t partialByte = partialBlock % 8;
-            partialBlock -= partialByte;
-
-            // Append the new data to the queue
-            memcpy(state->dataQueue + state->bitsInQueue/8, data + bitsAbsorbed/8, partialBlock/8);
-            state->bitsInQueue += partialBlock;
-            bitsAbsorbed += partialBlock;
-
-            // Absorb the queue if it fills a whole block
-            // A partial block will be left open for more data.
-            // If it is the last data, the data will be padded prior to squeezing.
-            if (state->bitsInQueue == state->rate) {
-                KeccakAbsorb(state->state, state->dataQueue, state->rate);
-                state->bitsInQueue = 0;
-            }
+    // Open a new block with the rest
+    KeccakXorBytesIntoState(state->state, data, 0, (uint32_t) dataByteLen);
+    KeccakCount(partialBlockBytes, dataByteLen);
+    state->bitsInBlock = dataByteLen * 8;
 
-            // If a partial byte is left over
-            if (partialByte > 0) {
-                // Mask the remaining bits
-                uint8_t mask = (1 << partialByte) - 1;
+    KeccakTimerStop(absorbNanoseconds, start);
 
-                // Add the masked bits to the queue
-                state->dataQueue[state->bitsInQueue/8] = data[bitsAbsorbed/8] & mask;
-                state->bitsInQueue += partialByte;
-                bitsAbsorbed += partialByte;
-            }
-        }
-    }
     return SUCCESS;
 }
 
-void PadAndSwitchToSqueezingPhase(SpongeState * state)
+SpongeReturn Absorb(SpongeState * state, const uint8_t * data, uint64_t dataBitLen)
 {
-    if (state->bitsInQueue + 1 == state->rate) { // The queue is one bit short of a block
-        // The MSB is the first bit of the pad10*1.
-        state->dataQueue[state->bitsInQueue/8] |= 1 << (state->bitsInQueue % 8);
+    SpongeReturn returnVal = AbsorbBytes(state, data, dataBitLen / 8);
 
-        // Then absorb the queue as another whole block
-        KeccakAbsorb(state->state, state->dataQueue, state->rate);
-        state->bitsInQueue = 0;
+    if ((returnVal == SUCCESS) && ((dataBitLen % 8) != 0)) {
+        // Add the last bits, masked, to the open block
+        uint8_t lastByte = data[dataBitLen / 8] & ((1 << (dataBitLen % 8)) - 1);
 
-        // Zero the queue to create a whole block of zeros
-        memset(state->dataQueue, 0, state->rate/8);
+        KeccakXorBytesIntoState(state->state, &lastByte, state->bitsInBlock / 8, 1);
+        KeccakCount(partialBlockBytes, 1);
+        state->bitsInBlock += dataBitLen % 8;
     }
-    else {
-        // Set the first bit after the data to the first 1 of the pad10*1
-        memset(state->dataQueue + (state->bitsInQueue + 7)/8, 0, state->rate/8 - (state->bitsInQueue + 7)/8);
 
-        // Zero the queue after the data to create the 0*
-        state->dataQueue[state->bitsInQueue/8] |= 1 << (state->bitsInQueue % 8);
+    return returnVal;
+}
+
+void PadAndSwitchToSqueezingPhase(SpongeState * state)
+{
+    // The delimited suffix holds the suffix bits and the first bit of the pad10*1,
+    // which may spill into another block when the open block is nearly full
+    uint32_t position = state->bitsInBlock;
+    uint8_t bits = state->delimitedSuffix;
+
+    while(bits != 0) {
+        if (position == state->rate) {
+            KeccakPermutationRounds(state->state, state->rounds);
+            KeccakCount(paddingBlocks, 1);
+            position = 0;
+        }
+        SpongeLane(state->state, position / 64) ^= (uint64_t) (bits & 1) << (position % 64);
+        position++;
+        bits >>= 1;
     }
 
-    // Set the final 1 of the pad10*1
-    state->dataQueue[(state->rate - 1)/8] |= 1 << ((state->rate - 1) % 8);
+    // When the first bit of the pad10*1 ended the block, its last bit goes in a block of zeros
+    if (position == state->rate) {
+        KeccakPermutationRounds(state->state, state->rounds);
+        KeccakCount(paddingBlocks, 1);
+    }
 
-    // Absorb the last block
-    KeccakAbsorb(state->state, state->dataQueue, state->rate);
-    state->bitsInQueue = 0;
+    // Set the final 1 of the pad10*1 and absorb the last block
+    SpongeLane(state->state, (state->rate - 1) / 64) ^= (uint64_t) 1 << ((state->rate - 1) % 64);
+    KeccakPermutationRounds(state->state, state->rounds);
+    state->bitsInBlock = 0;
 
-    // Extract one block into the queue
-    KeccakExtract(state->state, state->dataQueue, state->rate);
+    // The first block of output is read directly from the state
     state->bitsAvailableForSqueezing = state->rate;
 
     // Switch the sponge to squeezing mode
@@ -142,12 +252,19 @@ void PadAndSwitchToSqueezingPhase(SpongeState * state)
 
 SpongeReturn Squeeze(SpongeState * state, uint8_t * output, uint64_t outputLength)
 {
+    if (state->mode == DUPLEXING) {
+        return BAD_MODE;
+    }
+
+    KeccakTimerStart(start);
+
     if (state->mode != SQUEEZING) {
         PadAndSwitchToSqueezingPhase(state);
     }
 
     if ((outputLength % 8) != 0) {
         // Only multiple of 8 bits are allowed, truncation can be done at user level
+        KeccakTimerStop(squeezeNanoseconds, start);
         return BAD_HASHLEN;
     }
 
@@ -157,11 +274,17 @@ SpongeReturn Squeeze(SpongeState * state, uint8_t * output, uint64_t outputLengt
     while(bitsSqueezed < outputLength) {
 
         if (state->bitsAvailableForSqueezing == 0) {
-            // Permute the state
-            KeccakPermutation(state->state);
+            // Whole blocks go straight from the state into the output
+            uint64_t blocks = (outputLength - bitsSqueezed) / state->rate;
+            SqueezeWholeBlocks(state->state, state->rate, state->rounds, output + (bitsSqueezed / 8), blocks);
+            bitsSqueezed += blocks * state->rate;
+
+            if (bitsSqueezed == outputLength) {
+                break;
+            }
 
-            // Extract another rate of bits
-            KeccakExtract(state->state, state->dataQueue, state->rate);
+            // Permute the state to make another rate of bits available
+            KeccakPermutationRounds(state->state, state->rounds);
             state->bitsAvailableForSqueezing = state->rate;
         }
         
@@ -173,9 +296,11 @@ SpongeReturn Squeeze(SpongeState * state, uint8_t * output, uint64_t outputLengt
             bitsToSqueeze = state->bitsAvailableForSqueezing;
         }
         
-        memcpy(output + (bitsSqueezed / 8),
-               state->dataQueue + ((state->rate - state->bitsAvailableForSqueezing) / 8),
-               bitsToSqueeze / 8);
+        // Copy only the requested bytes out of the state
+        KeccakExtractBytes(state->state,
+                           output + (bitsSqueezed / 8),
+                           (state->rate - state->bitsAvailableForSqueezing) / 8,
+                           bitsToSqueeze / 8);
         
         state->bitsAvailableForSqueezing -= bitsToSqueeze;
         
@@ -183,9 +308,165 @@ SpongeReturn Squeeze(SpongeState * state, uint8_t * output, uint64_t outputLengt
 
     }
 
+    KeccakCount(squeezedBytes, outputLength / 8);
+    KeccakTimerStop(squeezeNanoseconds, start);
+
+    return SUCCESS;
+}
+
+/*
+ * Duplex construction
+ */
+SpongeReturn InitDuplex(SpongeState * state, uint32_t rate, uint32_t capacity)
+{
+    SpongeReturn returnVal = InitSponge(state, rate, capacity);
+
+    state->mode = DUPLEXING;
+
+    return returnVal;
+}
+
+/**
+  * The number of bits of a delimited suffix, including the first bit of the padding.
+  */
+static uint32_t DelimitedSuffixLength(uint8_t delimitedSuffix)
+{
+    uint32_t length = 0;
+    while(delimitedSuffix != 0) {
+        length++;
+        delimitedSuffix >>= 1;
+    }
+    return length;
+}
+
+SpongeReturn Duplexing(SpongeState * state, const uint8_t * input, uint32_t inputByteLen, uint8_t delimitedSuffix,
+                       uint8_t * output, uint32_t outputByteLen)
+{
+    if (state->mode != DUPLEXING) {
+        return BAD_MODE;
+    }
+    if (outputByteLen > state->rate/8) {
+        return BAD_HASHLEN;
+    }
+    if ((delimitedSuffix == 0) || ((uint64_t) inputByteLen * 8 + DelimitedSuffixLength(delimitedSuffix) + 1 > state->rate)) {
+        return FAIL;
+    }
+
+    // The input, its suffix with the first bit of the pad10*1, then the last bit of the pad10*1
+    KeccakXorBytesIntoState(state->state, input, 0, inputByteLen);
+    SpongeLane(state->state, inputByteLen / 8) ^= (uint64_t) delimitedSuffix << (8 * (inputByteLen % 8));
+    SpongeLane(state->state, (state->rate - 1) / 64) ^= (uint64_t) 1 << ((state->rate - 1) % 64);
+
+    KeccakPermutationRounds(state->state, state->rounds);
+
+    KeccakExtractBytes(state->state, output, 0, outputByteLen);
+
     return SUCCESS;
 }
 
+/*
+ * One-shot hashing of byte-aligned messages
+ */
+void SpongeOneShot(SpongeMatrix state, uint32_t rate, uint8_t delimitedSuffix,
+                   const uint8_t * data, uint64_t dataByteLen,
+                   uint8_t * output, uint64_t outputByteLen)
+{
+    SpongeOneShotRounds(state, rate, nrRounds, delimitedSuffix, data, dataByteLen, output, outputByteLen);
+}
+
+void SpongeOneShotRounds(SpongeMatrix state, uint32_t rate, uint32_t rounds, uint8_t delimitedSuffix,
+                         const uint8_t * data, uint64_t dataByteLen,
+                         uint8_t * output, uint64_t outputByteLen)
+{
+    // A message shorter than a block costs a single permutation
+    if ((dataByteLen < rate/8) && (outputByteLen <= rate/8)) {
+        KeccakInitialize(state);
+        XorTailAndPadding(state, rate, delimitedSuffix, data, (uint32_t) dataByteLen);
+        KeccakPermutationRounds(state, rounds);
+        ExtractOutputBytes(state, output, (uint32_t) outputByteLen);
+
+        KeccakCount(partialBlockBytes, dataByteLen);
+        KeccakCount(squeezedBytes, outputByteLen);
+        return;
+    }
+
+    switch(rate) {
+        case 576:  SpongeOneShot576(state, rounds, delimitedSuffix, data, dataByteLen, output, outputByteLen); return;
+        case 832:  SpongeOneShot832(state, rounds, delimitedSuffix, data, dataByteLen, output, outputByteLen); return;
+        case 1088: SpongeOneShot1088(state, rounds, delimitedSuffix, data, dataByteLen, output, outputByteLen); return;
+        case 1152: SpongeOneShot1152(state, rounds, delimitedSuffix, data, dataByteLen, output, outputByteLen); return;
+        case 1344: SpongeOneShot1344(state, rounds, delimitedSuffix, data, dataByteLen, output, outputByteLen); return;
+    }
+
+    KeccakInitialize(state);
+
+    uint64_t absorbed = AbsorbWholeBlocks(state, rate, rounds, data, dataByteLen);
+    data += absorbed;
+    dataByteLen -= absorbed;
+
+    XorTailAndPadding(state, rate, delimitedSuffix, data, dataByteLen);
+    KeccakCount(partialBlockBytes, dataByteLen);
+    KeccakCount(squeezedBytes, outputByteLen);
+    KeccakPermutationRounds(state, rounds);
+
+    while(outputByteLen > rate/8) {
+        KeccakExtract(state, output, rate);
+        output += rate/8;
+        outputByteLen -= rate/8;
+        KeccakPermutationRounds(state, rounds);
+    }
+
+    ExtractOutputBytes(state, output, (uint32_t) outputByteLen);
+}
+
+void SpongeOneShotTimes8(SpongeMatrix states[8], uint32_t rate, uint8_t delimitedSuffix,
+                         const uint8_t * data, uint64_t dataByteLen,
+                         uint8_t * outputs, uint32_t outputByteLen)
+{
+    SpongeOneShotRoundsTimes8(states, rate, nrRounds, delimitedSuffix, data, dataByteLen, outputs, outputByteLen);
+}
+
+void SpongeOneShotRoundsTimes8(SpongeMatrix states[8], uint32_t rate, uint32_t rounds, uint8_t delimitedSuffix,
+                               const uint8_t * data, uint64_t dataByteLen,
+                               uint8_t * outputs, uint32_t outputByteLen)
+{
+    const uint8_t * blockData[8];
+    uint64_t wholeBlocks = dataByteLen / (rate/8);
+    uint64_t block;
+    uint32_t s;
+
+    for(s = 0; s < 8; s++) {
+        KeccakInitialize(states[s]);
+        blockData[s] = data + s * dataByteLen;
+    }
+
+    for(block = 0; block < wholeBlocks; block++) {
+        KeccakAbsorbRoundsTimes8(states, blockData, rate, rounds);
+
+        for(s = 0; s < 8; s++) {
+            blockData[s] += rate/8;
+        }
+    }
+
+    for(s = 0; s < 8; s++) {
+        XorTailAndPadding(states[s], rate, delimitedSuffix, blockData[s], dataByteLen % (rate/8));
+    }
+    KeccakCount(fastPathBytes, 8 * wholeBlocks * (rate/8));
+    KeccakCount(fastPathBlocks, 8 * wholeBlocks);
+    KeccakCount(partialBlockBytes, 8 * (dataByteLen % (rate/8)));
+    KeccakCount(squeezedBytes, 8 * (uint64_t) outputByteLen);
+
+    KeccakPermutationRoundsTimes8(states, rounds);
+
+    for(s = 0; s < 8; s++) {
+        ExtractOutputBytes(states[s], outputs + s * outputByteLen, outputByteLen);
+    }
+}
+
+// SpongeState must stay within its documented size
+typedef char SpongeStateSizeCheck[(sizeof(SpongeState) <= KeccakSpongeStateSize) ? 1 : -1];
+
 void EraseState(SpongeState * state){
-    memset(state, 0, sizeof(SpongeState));
+    KeccakErase(state, sizeof(SpongeState));
+    KeccakEraseStack();
 }
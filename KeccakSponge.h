@@ -19,8 +19,29 @@
 #define ALIGN
 #endif
 
+// Backends that need x86 instructions are built with GCC-style target attributes
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KECCAK_X86
+#endif
+
 typedef uint64_t SpongeMatrix[5][5];
 
+/*
+ * The state is indexed as state[x][y], while the byte view of the state lists the
+ * lanes in the order x + 5y, each lane little-endian. SpongeLane addresses lane i
+ * of the byte view in place.
+ */
+#define SpongeLane(state, i) ((state)[(i) % 5][(i) / 5])
+
+/*
+ * Domain separation suffixes for SpongeState.delimitedSuffix and SpongeOneShot(), written as the suffix bits
+ * followed by the first bit of the pad10*1, least significant bit first.
+ */
+#define KeccakDelimitedSuffix   0x01    // Keccak[r, c], no suffix
+#define SHA3DelimitedSuffix     0x06    // SHA3-n, suffix 01
+#define SHAKEDelimitedSuffix    0x1F    // SHAKE128 and SHAKE256, suffix 1111
+#define cSHAKEDelimitedSuffix   0x04    // cSHAKE128 and cSHAKE256, suffix 00
+
 typedef enum {
     SUCCESS,
     FAIL,
@@ -28,33 +49,48 @@ typedef enum {
     BAD_RATE_CAPACITY,
     MODE_IS_SQUEEZING,
     PARTIAL_BYTES_IN_MULTIPLE_ABSORBS,
+    BAD_ROUNDS,
+    BAD_MODE,
 } SpongeReturn;
 
 typedef enum {
     ABSORBING,
     SQUEEZING,
+    DUPLEXING,
 } SpongeMode;
 
-ALIGN typedef struct SpongeStateStruct {
-    SpongeMatrix state;
-    
-    ALIGN uint8_t dataQueue[KeccakMaximumRateInBytes];
-    uint32_t bitsInQueue;
+/*
+ * The sponge keeps no input queue: a partial block is XORed into the state as it
+ * arrives and bitsInBlock counts how much of the current block has been absorbed.
+ * The context is the 200-byte state plus a few small fields, at most
+ * KeccakSpongeStateSize bytes, with the state aligned for the SIMD backends.
+ */
+#define KeccakSpongeStateSize 224
+#define KeccakSpongeStateAlignment 32
+
+typedef struct SpongeStateStruct {
+    ALIGN SpongeMatrix state;
+
+    uint16_t rate;
+    uint16_t bitsInBlock;
 
-    uint32_t rate;
-    uint32_t capacity;
-    
-    uint32_t fixedOutputLength;
+    // Bits of the current output block not yet squeezed
+    uint16_t bitsAvailableForSqueezing;
 
-    SpongeMode mode;
+    uint16_t fixedOutputLength;
 
-    uint32_t bitsAvailableForSqueezing;
-    
+    uint8_t rounds;
+
+    // Domain separation bits appended to the message before the pad10*1, as a delimited suffix
+    uint8_t delimitedSuffix;
+
+    uint8_t mode;               // A SpongeMode
 } SpongeState;
 
 /**
   * Function to initialize the state of the Keccak[r, c] sponge function.
-  * The sponge function is set to the absorbing phase.
+  * The sponge function is set to the absorbing phase, with no domain separation suffix.
+  * Set state->delimitedSuffix afterwards to append one, e.g. SHAKEDelimitedSuffix.
   * @param  state       Pointer to the state of the sponge function to be initialized.
   * @param  rate        The value of the rate r.
   * @param  capacity    The value of the capacity c.
@@ -65,6 +101,42 @@ ALIGN typedef struct SpongeStateStruct {
   */
 SpongeReturn InitSponge(SpongeState * state, uint32_t rate, uint32_t capacity);
 
+/**
+  * Function to initialize the state of a sponge function on Keccak-p[1600, rounds],
+  * the last @a rounds rounds of KeccakF, e.g. 12 for TurboSHAKE and KangarooTwelve.
+  * InitSponge() is the same with 24 rounds.
+  * @param  state       Pointer to the state of the sponge function to be initialized.
+  * @param  rate        The value of the rate r.
+  * @param  capacity    The value of the capacity c.
+  * @param  rounds      The number of rounds, from 1 to 24.
+  * @pre    One must have r+c=1600 and the rate a multiple of 64 bits in this implementation.
+  * @return SpongeReturn
+  *         BAD_RATE_CAPACITY - The r and c values are invalid for KeccakF[1600]
+  *         BAD_ROUNDS        - The number of rounds is not between 1 and 24
+  *         SUCCESS           - Sponge initialized
+  */
+SpongeReturn InitSpongeRounds(SpongeState * state, uint32_t rate, uint32_t capacity, uint32_t rounds);
+
+/**
+  * Return an initialized sponge to the start of the absorbing phase,
+  * keeping its rate, capacity and number of rounds.
+  * This is cheaper than InitSponge() when one sponge is reused for many messages.
+  * @param  state       Pointer to the state of the sponge function initialized by InitSponge().
+  */
+void ResetSponge(SpongeState * state);
+
+/**
+  * Copy a sponge, e.g. a snapshot taken after absorbing a common prefix, so that each
+  * message sharing the prefix starts from the copy instead of absorbing it again.
+  * The copy is in the same mode as @a source and continues exactly as @a source would:
+  * an absorbing copy takes more data with Absorb() (unless @a source ended on a partial
+  * byte, after which only Squeeze() is allowed), and a squeezing copy returns the same
+  * output as @a source from the same position. @a source is left unchanged.
+  * @param  destination Pointer to the sponge to overwrite, need not be initialized.
+  * @param  source      Pointer to the state of the sponge function initialized by InitSponge().
+  */
+void CloneSponge(SpongeState * destination, const SpongeState * source);
+
 /**
   * Function to give input data for the sponge function to absorb.
   * @param  state       Pointer to the state of the sponge function initialized by InitSponge().
@@ -80,24 +152,130 @@ SpongeReturn InitSponge(SpongeState * state, uint32_t rate, uint32_t capacity);
   *                           - Two Absorb calls in a row have had partial bytes.
   *                           - Only the last call to Absorb may have a partial byte.
   *         MODE_IS_SQUEEZING - Squeezing has begun, no more data can be added.
+  *         BAD_MODE          - The sponge was initialized by InitDuplex().
   *         SUCCESS           - Sponge initialized
   */
 SpongeReturn Absorb(SpongeState * state, const uint8_t * data, uint64_t dataBitLen);
 
+/**
+  * Function to give byte-aligned input data for the sponge function to absorb.
+  * This is the fast path under Absorb(): whole blocks are absorbed straight from
+  * @a data, and at most two partial blocks are XORed into the state per call.
+  * @param  state       Pointer to the state of the sponge function initialized by InitSponge().
+  * @param  data        Pointer to the input data.
+  * @param  dataByteLen The number of input bytes.
+  * @pre    The previous call to Absorb() did not end on a partial byte.
+  * @pre    The sponge function must be in the absorbing phase.
+  * @return SpongeReturn
+  *         PARTIAL_BYTES_IN_MULTIPLE_ABSORBS
+  *                           - The previous call to Absorb() had a partial byte.
+  *         MODE_IS_SQUEEZING - Squeezing has begun, no more data can be added.
+  *         BAD_MODE          - The sponge was initialized by InitDuplex().
+  *         SUCCESS           - Data absorbed
+  */
+SpongeReturn AbsorbBytes(SpongeState * state, const uint8_t * data, uint64_t dataByteLen);
+
 /**
   * Function to squeeze output data from the sponge function.
   * If the sponge function was in the absorbing phase, this function 
-  * switches it to the squeezing phase.
+  * appends the domain separation suffix and the padding and switches it to the squeezing phase.
+  * Whole blocks of output are extracted straight from the state into @a output.
   * @param  state       Pointer to the state of the sponge function initialized by InitSponge().
   * @param  output      Pointer to the buffer where to store the output data.
   * @param  outputLength    The number of output bits desired.
   *                     It must be a multiple of 8.
   * @return SpongeReturn
   *         BAD_HASHLEN - The output length must be a multiple of whole bytes.
+  *         BAD_MODE    - The sponge was initialized by InitDuplex().
   *         SUCCESS     - Sponge initialized
   */
 SpongeReturn Squeeze(SpongeState * state, uint8_t * output, uint64_t outputLength);
 
+/**
+  * Function to initialize the state of the Keccak[r, c] duplex construction.
+  * A duplex sponge takes input and gives output in the same call, Duplexing(),
+  * with one permutation per call and no end to the session.
+  * Absorb() and Squeeze() cannot be used on it.
+  * @param  state       Pointer to the state of the duplex object to be initialized.
+  * @param  rate        The value of the rate r.
+  * @param  capacity    The value of the capacity c.
+  * @pre    One must have r+c=1600 and the rate a multiple of 64 bits in this implementation.
+  * @return SpongeReturn
+  *         BAD_RATE_CAPACITY - The r and c values are invalid for KeccakF[1600]
+  *         SUCCESS           - Duplex object initialized
+  */
+SpongeReturn InitDuplex(SpongeState * state, uint32_t rate, uint32_t capacity);
+
+/**
+  * One call of the duplex construction: absorb a padded block and squeeze from the permuted state.
+  * The block is the input bytes, then the suffix bits of @a delimitedSuffix (e.g. a frame bit),
+  * then the pad10*1 up to the rate.
+  * @param  state       Pointer to the state of the duplex object initialized by InitDuplex().
+  * @param  input       Pointer to the input data.
+  * @param  inputByteLen    The number of input bytes. With the suffix bits and the two
+  *                     bits of padding, the block must fit in the rate.
+  * @param  delimitedSuffix The suffix bits followed by the first bit of the padding,
+  *                     e.g. KeccakDelimitedSuffix for none.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputByteLen   The number of output bytes, at most rate/8.
+  * @return SpongeReturn
+  *         BAD_MODE    - The sponge was not initialized by InitDuplex().
+  *         BAD_HASHLEN - The output is longer than the rate.
+  *         FAIL        - The input block does not fit in the rate.
+  *         SUCCESS     - Block processed
+  */
+SpongeReturn Duplexing(SpongeState * state, const uint8_t * input, uint32_t inputByteLen, uint8_t delimitedSuffix,
+                       uint8_t * output, uint32_t outputByteLen);
+
+/**
+  * Compute the output of the Keccak[r, c] sponge on a byte-aligned message in one call,
+  * without a SpongeState. Whole blocks are absorbed straight from @a data, and the
+  * last partial block, the domain separation suffix and the pad10*1 are XORed
+  * directly into the state. A message shorter than a block with at most a block
+  * of output takes a single permutation.
+  * @param  state       Pointer to a sponge matrix used as scratch space.
+  * @param  rate        The value of the rate r, a multiple of 64 bits.
+  * @param  delimitedSuffix The domain separation suffix, e.g. KeccakDelimitedSuffix.
+  * @param  data        Pointer to the input data.
+  * @param  dataByteLen The number of input bytes.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputByteLen   The number of output bytes.
+  */
+void SpongeOneShot(SpongeMatrix state, uint32_t rate, uint8_t delimitedSuffix,
+                   const uint8_t * data, uint64_t dataByteLen,
+                   uint8_t * output, uint64_t outputByteLen);
+
+/**
+  * SpongeOneShot() on Keccak-p[1600, rounds].
+  * @param  rounds      The number of rounds, from 1 to 24.
+  */
+void SpongeOneShotRounds(SpongeMatrix state, uint32_t rate, uint32_t rounds, uint8_t delimitedSuffix,
+                         const uint8_t * data, uint64_t dataByteLen,
+                         uint8_t * output, uint64_t outputByteLen);
+
+/**
+  * Compute SpongeOneShot() for eight messages of the same length stored back to back,
+  * running their permutations in lock-step with KeccakAbsorbTimes8().
+  * @param  states      Array of eight sponge matrices used as scratch space.
+  * @param  rate        The value of the rate r, a multiple of 64 bits.
+  * @param  delimitedSuffix The domain separation suffix, e.g. KeccakDelimitedSuffix.
+  * @param  data        Pointer to eight messages of @a dataByteLen bytes each.
+  * @param  dataByteLen The number of input bytes per message.
+  * @param  outputs     Pointer to a buffer for eight outputs of @a outputByteLen bytes each.
+  * @param  outputByteLen   The number of output bytes per message, at most rate/8.
+  */
+void SpongeOneShotTimes8(SpongeMatrix states[8], uint32_t rate, uint8_t delimitedSuffix,
+                         const uint8_t * data, uint64_t dataByteLen,
+                         uint8_t * outputs, uint32_t outputByteLen);
+
+/**
+  * SpongeOneShotTimes8() on Keccak-p[1600, rounds].
+  * @param  rounds      The number of rounds, from 1 to 24.
+  */
+void SpongeOneShotRoundsTimes8(SpongeMatrix states[8], uint32_t rate, uint32_t rounds, uint8_t delimitedSuffix,
+                               const uint8_t * data, uint64_t dataByteLen,
+                               uint8_t * outputs, uint32_t outputByteLen);
+
 /**
   * Erases memory used by the sponge function state to avoid leaking secret data.
   * @param  state       Pointer to the state of the sponge function initialized by InitSponge()
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "KeccakSponge.h"
+#include "KeccakErase.h"
+#include "KeccakSpongeArena.h"
+
+#define SpongeArenaDefaultContextsPerSlab 4096
+
+/*
+ * Slabs are chained through a header placed in front of their contexts, padded
+ * to keep the contexts aligned. Free contexts are chained through their first bytes.
+ */
+typedef struct SpongeSlabStruct {
+    struct SpongeSlabStruct * next;
+} SpongeSlab;
+
+#define SpongeSlabHeaderSize \
+    (((sizeof(SpongeSlab) + KeccakSpongeStateAlignment - 1) / KeccakSpongeStateAlignment) * KeccakSpongeStateAlignment)
+
+typedef union SpongeFreeContextUnion {
+    SpongeState state;
+    union SpongeFreeContextUnion * next;
+} SpongeFreeContext;
+
+struct SpongeArenaStruct {
+    SpongeSlab * slabs;
+    SpongeFreeContext * freeContexts;
+
+    // Contexts of the newest slab not handed out yet
+    uint8_t * nextContext;
+    uint32_t contextsLeft;
+
+    uint32_t contextsPerSlab;
+};
+
+SpongeArena * SpongeArenaCreate(uint32_t contextsPerSlab)
+{
+    SpongeArena * arena = malloc(sizeof(SpongeArena));
+
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    arena->slabs = NULL;
+    arena->freeContexts = NULL;
+    arena->nextContext = NULL;
+    arena->contextsLeft = 0;
+    arena->contextsPerSlab = (contextsPerSlab == 0) ? SpongeArenaDefaultContextsPerSlab : contextsPerSlab;
+
+    return arena;
+}
+
+SpongeState * SpongeArenaAllocate(SpongeArena * arena)
+{
+    SpongeState * state;
+
+    if (arena->freeContexts != NULL) {
+        state = &arena->freeContexts->state;
+        arena->freeContexts = arena->freeContexts->next;
+        return state;
+    }
+
+    if (arena->contextsLeft == 0) {
+        void * memory;
+
+        if (posix_memalign(&memory, KeccakSpongeStateAlignment,
+                           SpongeSlabHeaderSize + (size_t) arena->contextsPerSlab * sizeof(SpongeState)) != 0) {
+            return NULL;
+        }
+
+        SpongeSlab * slab = memory;
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+
+        arena->nextContext = (uint8_t *) memory + SpongeSlabHeaderSize;
+        arena->contextsLeft = arena->contextsPerSlab;
+    }
+
+    state = (SpongeState *) arena->nextContext;
+    arena->nextContext += sizeof(SpongeState);
+    arena->contextsLeft--;
+
+    return state;
+}
+
+void SpongeArenaFree(SpongeArena * arena, SpongeState * state)
+{
+    if (state == NULL) {
+        return;
+    }
+
+    EraseState(state);
+
+    SpongeFreeContext * context = (SpongeFreeContext *) state;
+    context->next = arena->freeContexts;
+    arena->freeContexts = context;
+}
+
+void SpongeArenaDestroy(SpongeArena * arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+
+    while(arena->slabs != NULL) {
+        SpongeSlab * slab = arena->slabs;
+        arena->slabs = slab->next;
+
+        // Clear memory of secret data
+        KeccakErase((uint8_t *) slab + SpongeSlabHeaderSize, (size_t) arena->contextsPerSlab * sizeof(SpongeState));
+        free(slab);
+    }
+
+    free(arena);
+}
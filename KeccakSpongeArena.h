@@ -0,0 +1,50 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+
+/*
+ * An arena of sponge contexts for programs holding very many of them at once,
+ * e.g. one incremental hash per stream of a multiplexed connection.
+ *
+ * Contexts are carved out of large slabs aligned to KeccakSpongeStateAlignment,
+ * so each costs sizeof(SpongeState) bytes with no per-allocation header and no
+ * call to malloc() once the arena has grown. Freed contexts are erased and reused
+ * first. An arena is not thread-safe; use one per thread.
+ */
+
+typedef struct SpongeArenaStruct SpongeArena;
+
+/**
+  * Create an empty arena.
+  * @param  contextsPerSlab The number of contexts allocated together when the arena grows,
+  *                     or 0 for a default of 4096.
+  * @return Pointer to the new arena, or NULL if memory could not be allocated.
+  */
+SpongeArena * SpongeArenaCreate(uint32_t contextsPerSlab);
+
+/**
+  * Take a context from the arena. It must be initialized, e.g. with InitSponge(), before use.
+  * @param  arena       Pointer to the arena.
+  * @return Pointer to a context aligned to KeccakSpongeStateAlignment, or NULL if memory
+  *         could not be allocated.
+  */
+SpongeState * SpongeArenaAllocate(SpongeArena * arena);
+
+/**
+  * Erase a context and return it to the arena.
+  * @param  arena       Pointer to the arena the context was taken from.
+  * @param  state       Pointer to the context, or NULL.
+  */
+void SpongeArenaFree(SpongeArena * arena, SpongeState * state);
+
+/**
+  * Erase every context and free the arena with all its slabs.
+  * @param  arena       Pointer to the arena created by SpongeArenaCreate(), or NULL.
+  */
+void SpongeArenaDestroy(SpongeArena * arena);
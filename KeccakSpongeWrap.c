@@ -0,0 +1,158 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+#include "KeccakErase.h"
+#include "KeccakSpongeWrap.h"
+
+// A frame bit followed by the first bit of the pad10*1
+#define FrameBit0 0x02
+#define FrameBit1 0x03
+
+static uint32_t BlockLength(uint64_t byteLen)
+{
+    return (byteLen < KeccakSpongeWrapBlockByteLen) ? (uint32_t) byteLen : KeccakSpongeWrapBlockByteLen;
+}
+
+/**
+  * Duplex every block of @a data but the last with @a frame, and return the length of the last block.
+  */
+static uint32_t DuplexAllButLastBlock(KeccakSpongeWrap * wrap, const uint8_t ** data, uint64_t byteLen, uint8_t frame)
+{
+    while(byteLen > KeccakSpongeWrapBlockByteLen) {
+        Duplexing(&wrap->duplex, *data, KeccakSpongeWrapBlockByteLen, frame, NULL, 0);
+        *data += KeccakSpongeWrapBlockByteLen;
+        byteLen -= KeccakSpongeWrapBlockByteLen;
+    }
+    return (uint32_t) byteLen;
+}
+
+/**
+  * Duplex the associated data and the body, turning @a input into @a output with the key stream.
+  * The duplex input is the plaintext: @a input when wrapping, @a output when unwrapping.
+  * Then squeeze the tag into @a tag, or compare it with @a receivedTag in constant time
+  * when @a tag is NULL, and return 0 if they match.
+  */
+static uint8_t ProcessMessage(KeccakSpongeWrap * wrap, const uint8_t * associatedData, uint64_t associatedDataByteLen,
+                              const uint8_t * input, uint64_t byteLen, uint8_t * output, int32_t unwrap,
+                              uint8_t * tag, const uint8_t * receivedTag, uint32_t tagByteLen)
+{
+    uint8_t keyStream[KeccakSpongeWrapBlockByteLen];
+    uint8_t difference = 0;
+    uint8_t block[KeccakSpongeWrapBlockByteLen];
+    uint64_t offset = 0;
+    uint32_t blockLength = BlockLength(byteLen);
+    uint32_t i;
+
+    uint32_t lastLength = DuplexAllButLastBlock(wrap, &associatedData, associatedDataByteLen, FrameBit0);
+    Duplexing(&wrap->duplex, associatedData, lastLength, FrameBit1, keyStream, blockLength);
+
+    while(1) {
+        // The plaintext block is kept aside, so that input and output may be the same buffer
+        for(i = 0; i < blockLength; i++) {
+            uint8_t value = input[offset + i];
+            output[offset + i] = value ^ keyStream[i];
+            block[i] = unwrap ? output[offset + i] : value;
+        }
+
+        if (offset + blockLength == byteLen) {
+            break;
+        }
+
+        uint32_t nextLength = BlockLength(byteLen - offset - blockLength);
+        Duplexing(&wrap->duplex, block, blockLength, FrameBit1, keyStream, nextLength);
+        offset += blockLength;
+        blockLength = nextLength;
+    }
+
+    // The last body block gives the first part of the tag, empty blocks the rest
+    uint32_t tagLength = BlockLength(tagByteLen);
+    Duplexing(&wrap->duplex, block, blockLength, FrameBit0, keyStream, tagLength);
+
+    offset = 0;
+    while(1) {
+        for(i = 0; i < tagLength; i++) {
+            if (tag != NULL) {
+                tag[offset + i] = keyStream[i];
+            } else {
+                difference |= keyStream[i] ^ receivedTag[offset + i];
+            }
+        }
+
+        offset += tagLength;
+        if (offset == tagByteLen) {
+            break;
+        }
+
+        tagLength = BlockLength(tagByteLen - offset);
+        Duplexing(&wrap->duplex, NULL, 0, FrameBit0, keyStream, tagLength);
+    }
+
+    KeccakSecureErase(keyStream, sizeof(keyStream)); // Clear memory of secret data
+    KeccakSecureErase(block, sizeof(block));
+
+    return difference;
+}
+
+SpongeReturn SpongeWrapInitialize(KeccakSpongeWrap * wrap, const uint8_t * key, uint64_t keyByteLen)
+{
+    SpongeReturn returnVal = InitDuplex(&wrap->duplex, KeccakSpongeWrapRate, 1600 - KeccakSpongeWrapRate);
+
+    if (returnVal == SUCCESS) {
+        uint32_t lastLength = DuplexAllButLastBlock(wrap, &key, keyByteLen, FrameBit1);
+        Duplexing(&wrap->duplex, key, lastLength, FrameBit0, NULL, 0);
+    }
+
+    wrap->failed = 0;
+
+    return returnVal;
+}
+
+SpongeReturn SpongeWrapWrap(KeccakSpongeWrap * wrap, const uint8_t * associatedData, uint64_t associatedDataByteLen,
+                            const uint8_t * plaintext, uint64_t plaintextByteLen,
+                            uint8_t * ciphertext, uint8_t * tag, uint32_t tagByteLen)
+{
+    if (wrap->failed) {
+        return FAIL;
+    }
+    if (tagByteLen < KeccakSpongeWrapMinTagByteLen) {
+        return BAD_HASHLEN;
+    }
+
+    ProcessMessage(wrap, associatedData, associatedDataByteLen, plaintext, plaintextByteLen, ciphertext, 0,
+                   tag, NULL, tagByteLen);
+
+    return SUCCESS;
+}
+
+SpongeReturn SpongeWrapUnwrap(KeccakSpongeWrap * wrap, const uint8_t * associatedData, uint64_t associatedDataByteLen,
+                              const uint8_t * ciphertext, uint64_t ciphertextByteLen,
+                              uint8_t * plaintext, const uint8_t * tag, uint32_t tagByteLen)
+{
+    if (wrap->failed) {
+        return FAIL;
+    }
+    if (tagByteLen < KeccakSpongeWrapMinTagByteLen) {
+        return BAD_HASHLEN;
+    }
+
+    uint8_t difference = ProcessMessage(wrap, associatedData, associatedDataByteLen, ciphertext, ciphertextByteLen,
+                                        plaintext, 1, NULL, tag, tagByteLen);
+
+    if (difference != 0) {
+        KeccakSecureErase(plaintext, ciphertextByteLen);
+        wrap->failed = 1;
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
+
+void SpongeWrapErase(KeccakSpongeWrap * wrap)
+{
+    KeccakSecureErase(&wrap->duplex, sizeof(wrap->duplex));
+    wrap->failed = 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+
+/*
+ * SpongeWrap authenticated encryption on the Keccak[1088, 512] duplex construction
+ *
+ * Data is cut into blocks of KeccakSpongeWrapBlockByteLen bytes (one empty block
+ * for empty data) and each duplexing call appends a frame bit to its block:
+ *   key:               K_0 .. K_u-2 with frame bit 1, K_u-1 with frame bit 0
+ *   associated data:   A_0 .. A_u-2 with frame bit 0, A_u-1 with frame bit 1,
+ *                      whose output encrypts B_0
+ *   body:              B_0 .. B_v-2 with frame bit 1, each output encrypting the
+ *                      next block, B_v-1 with frame bit 0, whose output starts the tag
+ *   longer tags:       empty blocks with frame bit 0
+ * so one permutation per block authenticates the body and encrypts it at once.
+ *
+ * The object is a session: every message wrapped or unwrapped is bound to all
+ * the messages before it, in order. The first associated data of a session must
+ * be a nonce unless the key is used for that session only. After a failed
+ * unwrap the session is unusable.
+ *
+ * Tags are at least KeccakSpongeWrapMinTagByteLen bytes. A shorter tag, and in
+ * particular one whose length is taken from the wire, is refused before the
+ * session is touched, as a tag of 0 bytes would authenticate anything.
+ */
+
+#define KeccakSpongeWrapRate 1088
+#define KeccakSpongeWrapBlockByteLen ((KeccakSpongeWrapRate - 3) / 8)
+#define KeccakSpongeWrapMinTagByteLen 16
+
+typedef struct {
+    SpongeState duplex;
+    int32_t failed;
+} KeccakSpongeWrap;
+
+/**
+  * Start a session with a key.
+  * @param  wrap        Pointer to the session.
+  * @param  key         Pointer to the key.
+  * @param  keyByteLen  The number of bytes in the key, e.g. 32.
+  * @return SpongeReturn
+  *         SUCCESS     - Session started
+  */
+SpongeReturn SpongeWrapInitialize(KeccakSpongeWrap * wrap, const uint8_t * key, uint64_t keyByteLen);
+
+/**
+  * Encrypt and authenticate a message.
+  * @param  wrap        Pointer to the session.
+  * @param  associatedData  Pointer to the associated data, authenticated but not encrypted.
+  * @param  associatedDataByteLen   The number of bytes of associated data, may be 0.
+  * @param  plaintext   Pointer to the plaintext.
+  * @param  plaintextByteLen    The number of bytes of plaintext, may be 0.
+  * @param  ciphertext  Pointer to the buffer for the ciphertext, as long as the plaintext;
+  *                     it may be the plaintext buffer itself.
+  * @param  tag         Pointer to the buffer for the tag.
+  * @param  tagByteLen  The number of bytes of tag, at least KeccakSpongeWrapMinTagByteLen, e.g. 16 or 32.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The tag is shorter than KeccakSpongeWrapMinTagByteLen; the session is unchanged.
+  *         FAIL        - An unwrap of this session has failed before.
+  *         SUCCESS     - Message wrapped
+  */
+SpongeReturn SpongeWrapWrap(KeccakSpongeWrap * wrap, const uint8_t * associatedData, uint64_t associatedDataByteLen,
+                            const uint8_t * plaintext, uint64_t plaintextByteLen,
+                            uint8_t * ciphertext, uint8_t * tag, uint32_t tagByteLen);
+
+/**
+  * Decrypt a message and check its tag. On failure the plaintext is erased.
+  * @param  wrap        Pointer to the session.
+  * @param  associatedData  Pointer to the associated data.
+  * @param  associatedDataByteLen   The number of bytes of associated data, may be 0.
+  * @param  ciphertext  Pointer to the ciphertext.
+  * @param  ciphertextByteLen   The number of bytes of ciphertext, may be 0.
+  * @param  plaintext   Pointer to the buffer for the plaintext, as long as the ciphertext;
+  *                     it may be the ciphertext buffer itself.
+  * @param  tag         Pointer to the tag received with the message.
+  * @param  tagByteLen  The number of bytes of tag, at least KeccakSpongeWrapMinTagByteLen.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The tag is shorter than KeccakSpongeWrapMinTagByteLen; the session is unchanged.
+  *         FAIL        - The tag does not match, or an unwrap of this session has failed before.
+  *         SUCCESS     - Message unwrapped and authentic
+  */
+SpongeReturn SpongeWrapUnwrap(KeccakSpongeWrap * wrap, const uint8_t * associatedData, uint64_t associatedDataByteLen,
+                              const uint8_t * ciphertext, uint64_t ciphertextByteLen,
+                              uint8_t * plaintext, const uint8_t * tag, uint32_t tagByteLen);
+
+/**
+  * Erase a session.
+  * @param  wrap        Pointer to the session.
+  */
+void SpongeWrapErase(KeccakSpongeWrap * wrap);
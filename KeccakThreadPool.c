@@ -0,0 +1,169 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "KeccakThreadPool.h"
+
+struct KeccakThreadPoolStruct {
+    pthread_mutex_t lock;
+    pthread_cond_t workAvailable;   // Signalled when a loop starts or the pool stops
+    pthread_cond_t workDone;        // Signalled when the last task of a loop finishes
+
+    pthread_t * workers;
+    uint32_t nrWorkers;
+
+    // The loop currently running, protected by lock
+    KeccakTask task;
+    void * context;
+    uint64_t nrTasks;
+    uint64_t nextTask;
+    uint64_t tasksDone;
+    uint64_t generation;            // Incremented for every loop so workers notice new work
+
+    int32_t stopping;
+};
+
+/**
+  * Claim and run tasks of the current loop until none are left.
+  * Called with the lock held, returns with the lock held.
+  */
+static void RunTasks(KeccakThreadPool * pool)
+{
+    while(pool->nextTask < pool->nrTasks) {
+        uint64_t index = pool->nextTask++;
+
+        pthread_mutex_unlock(&pool->lock);
+        pool->task(pool->context, index);
+        pthread_mutex_lock(&pool->lock);
+
+        pool->tasksDone++;
+        if (pool->tasksDone == pool->nrTasks) {
+            pthread_cond_broadcast(&pool->workDone);
+        }
+    }
+}
+
+static void * WorkerMain(void * argument)
+{
+    KeccakThreadPool * pool = argument;
+    uint64_t seenGeneration = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while(1) {
+        while(!pool->stopping && (pool->generation == seenGeneration)) {
+            pthread_cond_wait(&pool->workAvailable, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+
+        seenGeneration = pool->generation;
+        RunTasks(pool);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+KeccakThreadPool * KeccakThreadPoolCreate(uint32_t nrThreads)
+{
+    if (nrThreads == 0) {
+        long onlineCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+        nrThreads = (onlineCPUs > 0) ? (uint32_t) onlineCPUs : 1;
+    }
+
+    KeccakThreadPool * pool = calloc(1, sizeof(KeccakThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    // The thread calling KeccakThreadPoolRun() works too, so start one fewer
+    pool->workers = calloc(nrThreads, sizeof(pthread_t));
+    if (pool->workers == NULL) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workAvailable, NULL);
+    pthread_cond_init(&pool->workDone, NULL);
+
+    uint32_t i;
+    for(i = 0; i + 1 < nrThreads; i++) {
+        if (pthread_create(&pool->workers[i], NULL, WorkerMain, pool) != 0) {
+            KeccakThreadPoolDestroy(pool);
+            return NULL;
+        }
+        pool->nrWorkers++;
+    }
+
+    return pool;
+}
+
+void KeccakThreadPoolRun(KeccakThreadPool * pool, KeccakTask task, void * context, uint64_t nrTasks)
+{
+    uint64_t index;
+
+    if ((pool == NULL) || (pool->nrWorkers == 0) || (nrTasks == 1)) {
+        for(index = 0; index < nrTasks; index++) {
+            task(context, index);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    pool->task = task;
+    pool->context = context;
+    pool->nrTasks = nrTasks;
+    pool->nextTask = 0;
+    pool->tasksDone = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->workAvailable);
+
+    RunTasks(pool);
+
+    while(pool->tasksDone < pool->nrTasks) {
+        pthread_cond_wait(&pool->workDone, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+uint32_t KeccakThreadPoolSize(const KeccakThreadPool * pool)
+{
+    return (pool == NULL) ? 1 : pool->nrWorkers + 1;
+}
+
+void KeccakThreadPoolDestroy(KeccakThreadPool * pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->lock);
+
+    uint32_t i;
+    for(i = 0; i < pool->nrWorkers; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->workDone);
+    pthread_cond_destroy(&pool->workAvailable);
+    pthread_mutex_destroy(&pool->lock);
+
+    free(pool->workers);
+    free(pool);
+}
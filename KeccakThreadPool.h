@@ -0,0 +1,56 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * A fixed pool of worker threads running parallel loops.
+ *
+ * KeccakThreadPoolRun() hands out the task indices 0 .. nrTasks-1 to the
+ * workers and to the calling thread, and returns once every task is done.
+ * Tasks should be coarse (tens of kilobytes of hashing or more) because each
+ * index is claimed under a lock.
+ */
+
+typedef struct KeccakThreadPoolStruct KeccakThreadPool;
+
+/**
+  * Function run for each task of a parallel loop.
+  * @param  context     The context pointer passed to KeccakThreadPoolRun().
+  * @param  index       The index of the task, from 0 to nrTasks-1.
+  */
+typedef void (*KeccakTask)(void * context, uint64_t index);
+
+/**
+  * Start a thread pool.
+  * @param  nrThreads   Total number of threads running tasks, including the caller
+  *                     of KeccakThreadPoolRun(), or 0 for one per online CPU.
+  * @return Pointer to the new pool, or NULL if the threads could not be created.
+  */
+KeccakThreadPool * KeccakThreadPoolCreate(uint32_t nrThreads);
+
+/**
+  * Run @a task for every index from 0 to @a nrTasks-1 and wait until all are done.
+  * With a NULL @a pool the tasks run one after the other in the calling thread.
+  * Only one loop may run on a pool at a time.
+  * @param  pool        Pointer to the pool, or NULL.
+  * @param  task        Function to run for each index.
+  * @param  context     Pointer passed to every call of @a task.
+  * @param  nrTasks     The number of tasks.
+  */
+void KeccakThreadPoolRun(KeccakThreadPool * pool, KeccakTask task, void * context, uint64_t nrTasks);
+
+/**
+  * Get the number of threads running tasks, including the caller.
+  * @param  pool        Pointer to the pool, or NULL for 1.
+  */
+uint32_t KeccakThreadPoolSize(const KeccakThreadPool * pool);
+
+/**
+  * Stop the worker threads and free the pool.
+  * @param  pool        Pointer to the pool created by KeccakThreadPoolCreate(), or NULL.
+  */
+void KeccakThreadPoolDestroy(KeccakThreadPool * pool);
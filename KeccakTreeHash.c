@@ -0,0 +1,399 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "KeccakSponge.h"
+#include "KeccakErase.h"
+#include "KeccakF-1600-reference.h"
+#include "KeccakThreadPool.h"
+#include "KeccakSP800185.h"
+#include "KeccakTreeHash.h"
+
+// Number of leaves whose chaining values are computed before they are absorbed
+#define TreeWindowLeaves 16384
+
+// Amount of input each task hashes, so that claiming a task costs little in comparison
+#define TreeTaskBytes 65536
+
+// KangarooTwelve parameters
+#define KangarooTwelveRate 1344
+#define KangarooTwelveRounds 12
+#define KangarooTwelveChunkByteLen 8192
+#define KangarooTwelveChainingValueByteLen 32
+
+// Domain separation bytes of the TurboSHAKE calls in KangarooTwelve
+#define KangarooTwelveSingleNodeSuffix  0x07
+#define KangarooTwelveFinalNodeSuffix   0x06
+#define KangarooTwelveLeafSuffix        0x0B
+
+/*
+ * KangarooTwelve length_encode(x): x in big-endian without leading zeros, then the number of bytes
+ */
+static uint32_t LengthEncode(uint8_t * encoding, uint64_t value)
+{
+    uint32_t n = 0;
+    while((n < 8) && ((value >> (8 * n)) != 0)) {
+        n++;
+    }
+
+    uint32_t i;
+    for(i = 0; i < n; i++) {
+        encoding[i] = (uint8_t) (value >> (8 * (n - 1 - i)));
+    }
+
+    encoding[n] = (uint8_t) n;
+    return n + 1;
+}
+
+/*
+ * An input made of several byte strings, e.g. M || C || length_encode(|C|)
+ */
+typedef struct {
+    const uint8_t * data;
+    uint64_t byteLen;
+} ByteString;
+
+/**
+  * Absorb @a length bytes of the concatenation of @a pieces, starting at @a offset.
+  */
+static void AbsorbConcatenation(SpongeState * state, const ByteString * pieces, uint32_t nrPieces,
+                                uint64_t offset, uint64_t length)
+{
+    uint32_t i;
+    for(i = 0; (i < nrPieces) && (length > 0); i++) {
+        if (offset >= pieces[i].byteLen) {
+            offset -= pieces[i].byteLen;
+            continue;
+        }
+
+        uint64_t pieceLength = pieces[i].byteLen - offset;
+        if (pieceLength > length) {
+            pieceLength = length;
+        }
+
+        AbsorbBytes(state, pieces[i].data + offset, pieceLength);
+        length -= pieceLength;
+        offset = 0;
+    }
+}
+
+/**
+  * Copy @a length bytes of the concatenation of @a pieces, starting at @a offset.
+  */
+static void CopyConcatenation(uint8_t * output, const ByteString * pieces, uint32_t nrPieces,
+                              uint64_t offset, uint64_t length)
+{
+    uint32_t i;
+    for(i = 0; (i < nrPieces) && (length > 0); i++) {
+        if (offset >= pieces[i].byteLen) {
+            offset -= pieces[i].byteLen;
+            continue;
+        }
+
+        uint64_t pieceLength = pieces[i].byteLen - offset;
+        if (pieceLength > length) {
+            pieceLength = length;
+        }
+
+        memcpy(output, pieces[i].data + offset, pieceLength);
+        output += pieceLength;
+        length -= pieceLength;
+        offset = 0;
+    }
+}
+
+/*
+ * Leaves
+ */
+typedef struct {
+    const uint8_t * data;           // Input of the first leaf in the window
+    uint64_t dataByteLen;           // Input bytes in the window
+    uint64_t blockByteLen;          // Leaf size B
+    uint64_t nrLeaves;              // Leaves in the window
+    uint64_t leavesPerTask;
+
+    uint32_t rate;
+    uint32_t rounds;
+    uint8_t delimitedSuffix;
+
+    uint8_t * chainingValues;       // One chaining value per leaf, in order
+    uint32_t chainingValueByteLen;
+} LeafJob;
+
+static void HashLeaves(void * context, uint64_t task)
+{
+    const LeafJob * job = context;
+    SpongeMatrix states[8];
+
+    uint64_t leaf = task * job->leavesPerTask;
+    uint64_t lastLeaf = leaf + job->leavesPerTask;
+    if (lastLeaf > job->nrLeaves) {
+        lastLeaf = job->nrLeaves;
+    }
+
+    // Groups of eight whole leaves run in lock-step
+    while((leaf + 8 <= lastLeaf) && ((leaf + 8) * job->blockByteLen <= job->dataByteLen)) {
+        SpongeOneShotRoundsTimes8(states, job->rate, job->rounds, job->delimitedSuffix,
+                                  job->data + leaf * job->blockByteLen, job->blockByteLen,
+                                  job->chainingValues + leaf * job->chainingValueByteLen, job->chainingValueByteLen);
+        leaf += 8;
+    }
+
+    // The remaining leaves, including the last and possibly shorter one
+    for(; leaf < lastLeaf; leaf++) {
+        uint64_t leafByteLen = job->dataByteLen - leaf * job->blockByteLen;
+        if (leafByteLen > job->blockByteLen) {
+            leafByteLen = job->blockByteLen;
+        }
+
+        SpongeOneShotRounds(states[0], job->rate, job->rounds, job->delimitedSuffix,
+                            job->data + leaf * job->blockByteLen, leafByteLen,
+                            job->chainingValues + leaf * job->chainingValueByteLen, job->chainingValueByteLen);
+    }
+
+    KeccakErase(&states, sizeof(states)); // Clear memory of secret data
+}
+
+/**
+  * Hash every B-byte chunk of the data as a leaf and absorb the chaining values, in order, into @a state.
+  */
+static SpongeReturn AbsorbLeaves(SpongeState * state, const uint8_t * data, uint64_t dataByteLen,
+                                 uint64_t blockByteLen, uint32_t leafRate, uint32_t leafRounds, uint8_t leafSuffix,
+                                 uint32_t chainingValueByteLen, KeccakThreadPool * pool)
+{
+    uint64_t nrLeaves = (dataByteLen + blockByteLen - 1) / blockByteLen;
+    uint64_t windowLeaves = (nrLeaves < TreeWindowLeaves) ? nrLeaves : TreeWindowLeaves;
+
+    if (nrLeaves == 0) {
+        return SUCCESS;
+    }
+
+    uint8_t * chainingValues = malloc(windowLeaves * chainingValueByteLen);
+    if (chainingValues == NULL) {
+        return FAIL;
+    }
+
+    LeafJob job;
+    job.blockByteLen = blockByteLen;
+    job.rate = leafRate;
+    job.rounds = leafRounds;
+    job.delimitedSuffix = leafSuffix;
+    job.chainingValues = chainingValues;
+    job.chainingValueByteLen = chainingValueByteLen;
+
+    // Whole groups of eight leaves per task, at least TreeTaskBytes of input each
+    job.leavesPerTask = ((TreeTaskBytes / blockByteLen) + 7) & ~(uint64_t) 7;
+    if (job.leavesPerTask == 0) {
+        job.leavesPerTask = 8;
+    }
+
+    uint64_t firstLeaf;
+    for(firstLeaf = 0; firstLeaf < nrLeaves; firstLeaf += windowLeaves) {
+        job.nrLeaves = nrLeaves - firstLeaf;
+        if (job.nrLeaves > windowLeaves) {
+            job.nrLeaves = windowLeaves;
+        }
+
+        job.data = data + firstLeaf * blockByteLen;
+        job.dataByteLen = dataByteLen - firstLeaf * blockByteLen;
+        if (job.dataByteLen > job.nrLeaves * blockByteLen) {
+            job.dataByteLen = job.nrLeaves * blockByteLen;
+        }
+
+        KeccakThreadPoolRun(pool, HashLeaves, &job, (job.nrLeaves + job.leavesPerTask - 1) / job.leavesPerTask);
+
+        AbsorbBytes(state, chainingValues, job.nrLeaves * chainingValueByteLen);
+    }
+
+    KeccakErase(chainingValues, windowLeaves * chainingValueByteLen); // Clear memory of secret data
+    free(chainingValues);
+
+    return SUCCESS;
+}
+
+/*
+ * ParallelHash
+ */
+SpongeReturn ParallelHash(uint32_t securityStrength,
+                          const uint8_t * data, uint64_t dataByteLen, uint64_t blockByteLen,
+                          const uint8_t * customization, uint64_t customizationByteLen,
+                          uint8_t * output, uint64_t outputBitLen, int32_t xof,
+                          KeccakThreadPool * pool)
+{
+    static const uint8_t functionName[] = "ParallelHash";
+    SpongeState state;
+    SpongeReturn returnVal;
+    uint8_t encoding[9];
+    uint32_t encodingLength;
+
+    if ((securityStrength != 128) && (securityStrength != 256)) {
+        return BAD_RATE_CAPACITY;
+    }
+    if ((outputBitLen % 8) != 0) {
+        return BAD_HASHLEN;
+    }
+    if (blockByteLen == 0) {
+        return FAIL;
+    }
+
+    uint32_t rate = 1600 - 2 * securityStrength;
+
+    InitcSHAKE(&state, securityStrength, functionName, sizeof(functionName) - 1, customization, customizationByteLen);
+
+    encodingLength = SP800185LeftEncode(encoding, blockByteLen);
+    AbsorbBytes(&state, encoding, encodingLength);
+
+    // Each leaf is cSHAKE(X_i, 2s, "", "") = SHAKE(X_i, 2s)
+    returnVal = AbsorbLeaves(&state, data, dataByteLen, blockByteLen, rate, nrRounds, SHAKEDelimitedSuffix,
+                             2 * securityStrength / 8, pool);
+
+    if (returnVal == SUCCESS) {
+        encodingLength = SP800185RightEncode(encoding, (dataByteLen + blockByteLen - 1) / blockByteLen);
+        AbsorbBytes(&state, encoding, encodingLength);
+
+        encodingLength = SP800185RightEncode(encoding, xof ? 0 : outputBitLen);
+        AbsorbBytes(&state, encoding, encodingLength);
+
+        returnVal = Squeeze(&state, output, outputBitLen);
+    }
+
+    EraseState(&state);
+
+    return returnVal;
+}
+
+SpongeReturn ParallelHash128(const uint8_t * data, uint64_t dataByteLen, uint64_t blockByteLen,
+                             const uint8_t * customization, uint64_t customizationByteLen,
+                             uint8_t * output, uint64_t outputBitLen, KeccakThreadPool * pool)
+{
+    return ParallelHash(128, data, dataByteLen, blockByteLen, customization, customizationByteLen,
+                        output, outputBitLen, 0, pool);
+}
+
+SpongeReturn ParallelHash256(const uint8_t * data, uint64_t dataByteLen, uint64_t blockByteLen,
+                             const uint8_t * customization, uint64_t customizationByteLen,
+                             uint8_t * output, uint64_t outputBitLen, KeccakThreadPool * pool)
+{
+    return ParallelHash(256, data, dataByteLen, blockByteLen, customization, customizationByteLen,
+                        output, outputBitLen, 0, pool);
+}
+
+/*
+ * TurboSHAKE and KangarooTwelve
+ */
+SpongeReturn TurboSHAKE(uint32_t securityStrength, const uint8_t * data, uint64_t dataByteLen,
+                        uint8_t domainSeparation, uint8_t * output, uint64_t outputBitLen)
+{
+    SpongeMatrix state;
+
+    if ((securityStrength != 128) && (securityStrength != 256)) {
+        return BAD_RATE_CAPACITY;
+    }
+    if ((outputBitLen % 8) != 0) {
+        return BAD_HASHLEN;
+    }
+    if ((domainSeparation == 0) || (domainSeparation > 0x7F)) {
+        return FAIL;
+    }
+
+    SpongeOneShotRounds(state, 1600 - 2 * securityStrength, KangarooTwelveRounds, domainSeparation,
+                        data, dataByteLen, output, outputBitLen / 8);
+
+    KeccakErase(&state, sizeof(state)); // Clear memory of secret data
+    KeccakEraseStack();
+
+    return SUCCESS;
+}
+
+SpongeReturn KangarooTwelve(const uint8_t * data, uint64_t dataByteLen,
+                            const uint8_t * customization, uint64_t customizationByteLen,
+                            uint8_t * output, uint64_t outputBitLen, KeccakThreadPool * pool)
+{
+    static const uint8_t firstNodeMarker[8] = {0x03, 0, 0, 0, 0, 0, 0, 0};
+    static const uint8_t finalNodeMarker[2] = {0xFF, 0xFF};
+    SpongeState state;
+    SpongeReturn returnVal = SUCCESS;
+    uint8_t customizationLength[9];
+    uint8_t encoding[9];
+    uint32_t encodingLength;
+
+    if ((outputBitLen % 8) != 0) {
+        return BAD_HASHLEN;
+    }
+
+    // S = M || C || length_encode(|C|)
+    ByteString input[3];
+    input[0].data = data;
+    input[0].byteLen = dataByteLen;
+    input[1].data = customization;
+    input[1].byteLen = customizationByteLen;
+    input[2].data = customizationLength;
+    input[2].byteLen = LengthEncode(customizationLength, customizationByteLen);
+
+    uint64_t inputByteLen = input[0].byteLen + input[1].byteLen + input[2].byteLen;
+
+    InitSpongeRounds(&state, KangarooTwelveRate, 1600 - KangarooTwelveRate, KangarooTwelveRounds);
+
+    if (inputByteLen <= KangarooTwelveChunkByteLen) {
+        // A single node: TurboSHAKE128(S, 07)
+        AbsorbConcatenation(&state, input, 3, 0, inputByteLen);
+        state.delimitedSuffix = KangarooTwelveSingleNodeSuffix;
+    }
+    else {
+        // The final node starts with the first chunk S_0
+        AbsorbConcatenation(&state, input, 3, 0, KangarooTwelveChunkByteLen);
+        AbsorbBytes(&state, firstNodeMarker, sizeof(firstNodeMarker));
+
+        // Leaves made only of message bytes are hashed in place
+        uint64_t wholeChunks = dataByteLen / KangarooTwelveChunkByteLen;
+        uint64_t inPlaceLeaves = (wholeChunks > 1) ? wholeChunks - 1 : 0;
+
+        // With none, data + KangarooTwelveChunkByteLen may point past the end of M
+        returnVal = SUCCESS;
+        if (inPlaceLeaves > 0) {
+            returnVal = AbsorbLeaves(&state, data + KangarooTwelveChunkByteLen, inPlaceLeaves * KangarooTwelveChunkByteLen,
+                                     KangarooTwelveChunkByteLen, KangarooTwelveRate, KangarooTwelveRounds,
+                                     KangarooTwelveLeafSuffix, KangarooTwelveChainingValueByteLen, pool);
+        }
+
+        // The remaining leaves span the end of M, C and its length, so they are copied together first
+        if (returnVal == SUCCESS) {
+            uint64_t tailOffset = (inPlaceLeaves + 1) * KangarooTwelveChunkByteLen;
+            uint64_t tailByteLen = inputByteLen - tailOffset;
+            uint8_t * tail = malloc(tailByteLen);
+
+            if (tail == NULL) {
+                returnVal = FAIL;
+            }
+            else {
+                CopyConcatenation(tail, input, 3, tailOffset, tailByteLen);
+
+                returnVal = AbsorbLeaves(&state, tail, tailByteLen,
+                                         KangarooTwelveChunkByteLen, KangarooTwelveRate, KangarooTwelveRounds,
+                                         KangarooTwelveLeafSuffix, KangarooTwelveChainingValueByteLen, pool);
+
+                KeccakErase(tail, tailByteLen); // Clear memory of secret data
+                free(tail);
+            }
+        }
+
+        if (returnVal == SUCCESS) {
+            encodingLength = LengthEncode(encoding, (inputByteLen - 1) / KangarooTwelveChunkByteLen);
+            AbsorbBytes(&state, encoding, encodingLength);
+            AbsorbBytes(&state, finalNodeMarker, sizeof(finalNodeMarker));
+            state.delimitedSuffix = KangarooTwelveFinalNodeSuffix;
+        }
+    }
+
+    if (returnVal == SUCCESS) {
+        returnVal = Squeeze(&state, output, outputBitLen);
+    }
+
+    EraseState(&state);
+
+    return returnVal;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "KeccakSponge.h"
+#include "KeccakThreadPool.h"
+
+/*
+ * Tree hashing
+ *
+ * The input is cut into fixed-size chunks. Each chunk is hashed on its own
+ * (a leaf), possibly on another thread, and the chaining values of the leaves
+ * are absorbed in order by a final sponge. Because the leaves are independent,
+ * the work spreads over the threads of a KeccakThreadPool, and groups of eight
+ * leaves also share their permutations through SpongeOneShotTimes8().
+ *
+ * ParallelHash128 and ParallelHash256 follow NIST SP 800-185:
+ *   z = left_encode(B) || SHAKE(X_0, 2s) || ... || SHAKE(X_n-1, 2s) || right_encode(n) || right_encode(L)
+ *   ParallelHash(X, B, L, S) = cSHAKE(z, L, "ParallelHash", S)
+ * where s is the security strength. The XOF variants encode L as 0.
+ *
+ * KangarooTwelve (RFC 9861) runs TurboSHAKE128, a sponge on the 12-round
+ * Keccak-p[1600, 12], over 8192-byte chunks of S = M || C || length_encode(|C|):
+ *   |S| <= 8192: TurboSHAKE128(S, 07)
+ *   otherwise:   TurboSHAKE128(S_0 || 03 00^7 || CV_1 || ... || CV_n-1 || length_encode(n-1) || FF FF, 06)
+ *                with CV_i = TurboSHAKE128(S_i, 0B) truncated to 32 bytes.
+ */
+
+/**
+  * Compute ParallelHash128 or ParallelHash256 of a byte-aligned message.
+  * @param  securityStrength    128 or 256.
+  * @param  data        Pointer to the input data.
+  * @param  dataByteLen The number of input bytes.
+  * @param  blockByteLen    The chunk size B in bytes, greater than 0.
+  * @param  customization   Pointer to the customization string S.
+  * @param  customizationByteLen    The number of bytes in S, may be 0.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits L, a multiple of 8.
+  * @param  xof         1 for ParallelHashXOF (L is not bound into the output), 0 otherwise.
+  * @param  pool        Thread pool hashing the leaves, or NULL to hash them in the calling thread.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The output length is not a multiple of 8 bits.
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         FAIL        - The chunk size is 0 or memory could not be allocated.
+  *         SUCCESS     - The output was computed.
+  */
+SpongeReturn ParallelHash(uint32_t securityStrength,
+                          const uint8_t * data, uint64_t dataByteLen, uint64_t blockByteLen,
+                          const uint8_t * customization, uint64_t customizationByteLen,
+                          uint8_t * output, uint64_t outputBitLen, int32_t xof,
+                          KeccakThreadPool * pool);
+
+/**
+  * ParallelHash128(X, B, L, S), see ParallelHash().
+  */
+SpongeReturn ParallelHash128(const uint8_t * data, uint64_t dataByteLen, uint64_t blockByteLen,
+                             const uint8_t * customization, uint64_t customizationByteLen,
+                             uint8_t * output, uint64_t outputBitLen, KeccakThreadPool * pool);
+
+/**
+  * ParallelHash256(X, B, L, S), see ParallelHash().
+  */
+SpongeReturn ParallelHash256(const uint8_t * data, uint64_t dataByteLen, uint64_t blockByteLen,
+                             const uint8_t * customization, uint64_t customizationByteLen,
+                             uint8_t * output, uint64_t outputBitLen, KeccakThreadPool * pool);
+
+/**
+  * Compute TurboSHAKE128 or TurboSHAKE256 of a byte-aligned message.
+  * @param  securityStrength    128 or 256.
+  * @param  data        Pointer to the input data.
+  * @param  dataByteLen The number of input bytes.
+  * @param  domainSeparation    The domain separation byte D, from 0x01 to 0x7F, 0x1F by default.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits, a multiple of 8.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The output length is not a multiple of 8 bits.
+  *         BAD_RATE_CAPACITY - The security strength is not 128 or 256.
+  *         FAIL        - The domain separation byte is out of range.
+  *         SUCCESS     - The output was computed.
+  */
+SpongeReturn TurboSHAKE(uint32_t securityStrength, const uint8_t * data, uint64_t dataByteLen,
+                        uint8_t domainSeparation, uint8_t * output, uint64_t outputBitLen);
+
+/**
+  * Compute KangarooTwelve of a byte-aligned message.
+  * @param  data        Pointer to the input data M.
+  * @param  dataByteLen The number of input bytes.
+  * @param  customization   Pointer to the customization string C.
+  * @param  customizationByteLen    The number of bytes in C, may be 0.
+  * @param  output      Pointer to the buffer where to store the output data.
+  * @param  outputBitLen    The number of output bits, a multiple of 8.
+  * @param  pool        Thread pool hashing the leaves, or NULL to hash them in the calling thread.
+  * @return SpongeReturn
+  *         BAD_HASHLEN - The output length is not a multiple of 8 bits.
+  *         FAIL        - Memory could not be allocated.
+  *         SUCCESS     - The output was computed.
+  */
+SpongeReturn KangarooTwelve(const uint8_t * data, uint64_t dataByteLen,
+                            const uint8_t * customization, uint64_t customizationByteLen,
+                            uint8_t * output, uint64_t outputBitLen, KeccakThreadPool * pool);
@@ -0,0 +1,685 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+/*
+ * keccakbench: throughput and latency of the permutation, sponge and NIST API
+ *
+ * Throughput cases run a calibrated number of operations per trial and report
+ * the fastest of several trials, as nanoseconds and cycles per operation,
+ * cycles per byte and GB/s (10^9 bytes per second). Cycles are read with
+ * RDTSC, which counts at the nominal frequency of the CPU, so they differ from
+ * core cycles when turbo or power saving changes the clock. Without a cycle
+ * counter the cycle columns are 0.
+ *
+ * The thread scaling cases run one Hash() per thread of a KeccakThreadPool at
+ * once, for 1, 2, 4, ... threads up to the number of online CPUs, so GB/s per
+ * thread count shows how throughput scales per core.
+ *
+ * Latency cases time single Hash() calls on small messages and report
+ * percentiles and a histogram with power-of-two buckets, in cycles (or in
+ * nanoseconds without a cycle counter).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "KeccakNISTInterface.h"
+#include "KeccakF-1600-reference.h"
+#include "KeccakF-1600-times.h"
+#include "KeccakF-1600-dispatch.h"
+#include "KeccakThreadPool.h"
+#include "KeccakDRBG.h"
+
+#if defined(KECCAK_X86)
+#include <x86intrin.h>
+#endif
+
+#define nrTrials 5
+#define nrHistogramBuckets 32
+
+typedef enum {
+    TEXT,
+    CSV,
+    JSON,
+} OutputFormat;
+
+static OutputFormat outputFormat = TEXT;
+static uint64_t minimumTrialNanoseconds = 100000000;    // --min-time, in ms on the command line
+static uint64_t maximumMessageBytes = (uint64_t) 1 << 30; // --max-size
+static uint32_t latencySamples = 100000;
+static uint32_t rowsPrinted = 0;
+
+// Results are folded into this so that the compiler cannot drop the work
+static volatile uint64_t sink;
+
+/*
+ * Clocks
+ */
+static uint64_t ReadCycles(void)
+{
+#if defined(KECCAK_X86)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static uint64_t ReadNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static const char * LatencyUnit(void)
+{
+    return (ReadCycles() != 0) ? "cycles" : "ns";
+}
+
+static uint64_t ReadLatencyClock(void)
+{
+#if defined(KECCAK_X86)
+    return __rdtsc();
+#else
+    return ReadNanoseconds();
+#endif
+}
+
+/*
+ * Output
+ */
+static void PrintHeader(void)
+{
+    const char * backend = KeccakGetBackend()->name;
+
+    if (outputFormat == TEXT) {
+        printf("Backend: %s\n\n", backend);
+        printf("%-10s %-28s %12s %12s %14s %12s %10s\n",
+               "group", "case", "bytes", "ns/op", "cycles/op", "cycles/byte", "GB/s");
+    }
+    else if (outputFormat == CSV) {
+        printf("kind,group,case,bytes,iterations,ns_per_op,cycles_per_op,cycles_per_byte,gb_per_s,"
+               "unit,samples,p50,p90,p99,p999,max\n");
+    }
+    else {
+        printf("{\n  \"backend\": \"%s\",\n  \"throughput\": [", backend);
+    }
+}
+
+static void PrintThroughput(const char * group, const char * name, uint64_t bytes, uint64_t iterations,
+                            double nanosecondsPerOp, double cyclesPerOp)
+{
+    double cyclesPerByte = (bytes > 0) ? cyclesPerOp / (double) bytes : 0;
+    double gigabytesPerSecond = (nanosecondsPerOp > 0) ? (double) bytes / nanosecondsPerOp : 0;
+
+    if (outputFormat == TEXT) {
+        printf("%-10s %-28s %12llu %12.1f %14.1f %12.2f %10.3f\n", group, name, (unsigned long long) bytes,
+               nanosecondsPerOp, cyclesPerOp, cyclesPerByte, gigabytesPerSecond);
+    }
+    else if (outputFormat == CSV) {
+        printf("throughput,%s,%s,%llu,%llu,%.3f,%.3f,%.4f,%.4f,,,,,,,\n", group, name,
+               (unsigned long long) bytes, (unsigned long long) iterations,
+               nanosecondsPerOp, cyclesPerOp, cyclesPerByte, gigabytesPerSecond);
+    }
+    else {
+        printf("%s\n    {\"group\": \"%s\", \"case\": \"%s\", \"bytes\": %llu, \"iterations\": %llu, "
+               "\"ns_per_op\": %.3f, \"cycles_per_op\": %.3f, \"cycles_per_byte\": %.4f, \"gb_per_s\": %.4f}",
+               (rowsPrinted > 0) ? "," : "", group, name, (unsigned long long) bytes, (unsigned long long) iterations,
+               nanosecondsPerOp, cyclesPerOp, cyclesPerByte, gigabytesPerSecond);
+    }
+    fflush(stdout);
+    rowsPrinted++;
+}
+
+static void StartLatencySection(void)
+{
+    if (outputFormat == TEXT) {
+        printf("\n%-10s %-28s %12s %8s %10s %10s %10s %10s %10s\n",
+               "group", "case", "bytes", "unit", "p50", "p90", "p99", "p99.9", "max");
+    }
+    else if (outputFormat == JSON) {
+        printf("\n  ],\n  \"latency\": [");
+    }
+    rowsPrinted = 0;
+}
+
+static void PrintLatency(const char * name, uint64_t bytes, const uint64_t * sorted, uint32_t count,
+                         const uint64_t buckets[nrHistogramBuckets])
+{
+    uint64_t p50 = sorted[count / 2];
+    uint64_t p90 = sorted[(uint64_t) count * 90 / 100];
+    uint64_t p99 = sorted[(uint64_t) count * 99 / 100];
+    uint64_t p999 = sorted[(uint64_t) count * 999 / 1000];
+    uint64_t maximum = sorted[count - 1];
+    uint32_t b;
+
+    if (outputFormat == TEXT) {
+        printf("%-10s %-28s %12llu %8s %10llu %10llu %10llu %10llu %10llu\n", "latency", name,
+               (unsigned long long) bytes, LatencyUnit(), (unsigned long long) p50, (unsigned long long) p90,
+               (unsigned long long) p99, (unsigned long long) p999, (unsigned long long) maximum);
+
+        // One bar per non-empty bucket [2^b, 2^(b+1)), scaled to the fullest bucket
+        uint64_t fullest = 1;
+        for(b = 0; b < nrHistogramBuckets; b++) {
+            fullest = (buckets[b] > fullest) ? buckets[b] : fullest;
+        }
+        for(b = 0; b < nrHistogramBuckets; b++) {
+            if (buckets[b] > 0) {
+                uint32_t width = (uint32_t) ((buckets[b] * 50 + fullest - 1) / fullest);
+                printf("%52s[%8llu, %8llu) %9llu ", "", (unsigned long long) 1 << b,
+                       (unsigned long long) 1 << (b + 1), (unsigned long long) buckets[b]);
+                while(width-- > 0) {
+                    putchar('#');
+                }
+                putchar('\n');
+            }
+        }
+    }
+    else if (outputFormat == CSV) {
+        printf("latency,latency,%s,%llu,,,,,,%s,%u,%llu,%llu,%llu,%llu,%llu\n", name, (unsigned long long) bytes,
+               LatencyUnit(), count, (unsigned long long) p50, (unsigned long long) p90, (unsigned long long) p99,
+               (unsigned long long) p999, (unsigned long long) maximum);
+    }
+    else {
+        printf("%s\n    {\"case\": \"%s\", \"bytes\": %llu, \"unit\": \"%s\", \"samples\": %u, "
+               "\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu, \"buckets\": [",
+               (rowsPrinted > 0) ? "," : "", name, (unsigned long long) bytes, LatencyUnit(), count,
+               (unsigned long long) p50, (unsigned long long) p90, (unsigned long long) p99,
+               (unsigned long long) p999, (unsigned long long) maximum);
+
+        // Bucket b counts the samples in [2^b, 2^(b+1))
+        for(b = 0; b < nrHistogramBuckets; b++) {
+            printf("%s%llu", (b > 0) ? ", " : "", (unsigned long long) buckets[b]);
+        }
+        printf("]}");
+    }
+    fflush(stdout);
+    rowsPrinted++;
+}
+
+static void PrintFooter(void)
+{
+    if (outputFormat == JSON) {
+        printf("\n  ]\n}\n");
+    }
+}
+
+/*
+ * Throughput measurement
+ */
+typedef void (*BenchFunction)(void * context, uint64_t iterations);
+
+/**
+  * Run @a function for enough iterations that a trial takes at least the minimum trial time,
+  * and report the fastest of nrTrials trials.
+  */
+static void Measure(const char * group, const char * name, uint64_t bytesPerOp,
+                    BenchFunction function, void * context)
+{
+    uint64_t iterations = 1;
+    uint64_t startNanoseconds, startCycles;
+    uint64_t elapsedNanoseconds, elapsedCycles;
+
+    // Warm up and find the iteration count, doubling until a trial is long enough
+    while(1) {
+        startNanoseconds = ReadNanoseconds();
+        startCycles = ReadCycles();
+        function(context, iterations);
+        elapsedCycles = ReadCycles() - startCycles;
+        elapsedNanoseconds = ReadNanoseconds() - startNanoseconds;
+
+        if (elapsedNanoseconds >= minimumTrialNanoseconds) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double bestNanoseconds = (double) elapsedNanoseconds / (double) iterations;
+    double bestCycles = (double) elapsedCycles / (double) iterations;
+
+    // A single operation that already fills a trial, such as hashing 1 GiB, is not repeated
+    uint32_t trial;
+    for(trial = 0; (iterations > 1) && (trial < nrTrials); trial++) {
+        startNanoseconds = ReadNanoseconds();
+        startCycles = ReadCycles();
+        function(context, iterations);
+        elapsedCycles = ReadCycles() - startCycles;
+        elapsedNanoseconds = ReadNanoseconds() - startNanoseconds;
+
+        if ((double) elapsedNanoseconds / (double) iterations < bestNanoseconds) {
+            bestNanoseconds = (double) elapsedNanoseconds / (double) iterations;
+            bestCycles = (double) elapsedCycles / (double) iterations;
+        }
+    }
+
+    PrintThroughput(group, name, bytesPerOp, iterations, bestNanoseconds, bestCycles);
+}
+
+/*
+ * Permutation
+ */
+typedef struct {
+    const KeccakBackend * backend;
+    uint32_t rounds;
+    SpongeMatrix states[KeccakMaxParallelism];
+} PermutationContext;
+
+static void BenchPermutation(void * context, uint64_t iterations)
+{
+    PermutationContext * bench = context;
+    uint64_t i;
+
+    for(i = 0; i < iterations; i++) {
+        if (bench->rounds == nrRounds) {
+            bench->backend->permutation(bench->states[0]);
+        } else {
+            bench->backend->permutationRounds(bench->states[0], bench->rounds);
+        }
+    }
+    sink += bench->states[0][0][0];
+}
+
+static void BenchPermutationTimes8(void * context, uint64_t iterations)
+{
+    PermutationContext * bench = context;
+    uint64_t i;
+
+    for(i = 0; i < iterations; i++) {
+        KeccakPermutationRoundsTimes8(bench->states, bench->rounds);
+    }
+    sink += bench->states[7][0][0];
+}
+
+static void RunPermutationBenchmarks(void)
+{
+    static PermutationContext bench;
+    char name[64];
+    uint32_t backendCount, i;
+    const KeccakBackend * backends = KeccakListBackends(&backendCount);
+
+    memset(&bench, 0, sizeof(bench));
+
+    // Each backend on its own, with the 200-byte state as the bytes per operation
+    for(i = 0; i < backendCount; i++) {
+        if (!backends[i].isSupported()) {
+            continue;
+        }
+        bench.backend = &backends[i];
+
+        bench.rounds = nrRounds;
+        snprintf(name, sizeof(name), "KeccakF-1600 %s", backends[i].name);
+        Measure("permute", name, KeccakPermutationSizeInBytes, BenchPermutation, &bench);
+
+        bench.rounds = 12;
+        snprintf(name, sizeof(name), "KeccakF-1600 12 rounds %s", backends[i].name);
+        Measure("permute", name, KeccakPermutationSizeInBytes, BenchPermutation, &bench);
+    }
+
+    // Eight states at once through the active backend
+    bench.rounds = nrRounds;
+    Measure("permute", "KeccakF-1600 times8", 8 * KeccakPermutationSizeInBytes, BenchPermutationTimes8, &bench);
+}
+
+/*
+ * Sponge
+ */
+#define SpongeBufferBytes (1 << 20)
+
+typedef struct {
+    SpongeState state;
+    uint8_t * buffer;
+} SpongeContext;
+
+static void BenchAbsorb(void * context, uint64_t iterations)
+{
+    SpongeContext * bench = context;
+    uint64_t i;
+
+    for(i = 0; i < iterations; i++) {
+        AbsorbBytes(&bench->state, bench->buffer, SpongeBufferBytes);
+    }
+    sink += bench->state.state[0][0];
+}
+
+static void BenchSqueeze(void * context, uint64_t iterations)
+{
+    SpongeContext * bench = context;
+    uint64_t i;
+
+    for(i = 0; i < iterations; i++) {
+        Squeeze(&bench->state, bench->buffer, (uint64_t) SpongeBufferBytes * 8);
+    }
+    sink += bench->buffer[0];
+}
+
+static void RunSpongeBenchmarks(void)
+{
+    // The rates of Keccak-512, -384, -256 and -224, then SHAKE128 for squeezing
+    static const uint32_t rates[] = {576, 832, 1088, 1152};
+    static SpongeContext bench;
+    char name[64];
+    uint32_t i;
+
+    bench.buffer = calloc(SpongeBufferBytes, 1);
+    if (bench.buffer == NULL) {
+        fprintf(stderr, "Out of memory for the sponge benchmarks\n");
+        return;
+    }
+
+    for(i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        InitSponge(&bench.state, rates[i], 1600 - rates[i]);
+        snprintf(name, sizeof(name), "Absorb r=%u", rates[i]);
+        Measure("sponge", name, SpongeBufferBytes, BenchAbsorb, &bench);
+    }
+
+    for(i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        InitSponge(&bench.state, rates[i], 1600 - rates[i]);
+        snprintf(name, sizeof(name), "Squeeze r=%u", rates[i]);
+        Measure("sponge", name, SpongeBufferBytes, BenchSqueeze, &bench);
+    }
+
+    InitSponge(&bench.state, 1344, 256);
+    Measure("sponge", "Squeeze r=1344", SpongeBufferBytes, BenchSqueeze, &bench);
+
+    EraseState(&bench.state);
+    free(bench.buffer);
+}
+
+/*
+ * Random bit generation
+ */
+typedef struct {
+    KeccakDRBG drbg;
+    uint8_t * buffer;
+    uint32_t requestByteLen;
+} DRBGContext;
+
+static void BenchDRBG(void * context, uint64_t iterations)
+{
+    DRBGContext * bench = context;
+    uint64_t i;
+
+    for(i = 0; i < iterations; i++) {
+        KeccakDRBGGenerate(&bench->drbg, bench->buffer, bench->requestByteLen);
+    }
+    sink += bench->buffer[0];
+}
+
+static void RunDRBGBenchmarks(void)
+{
+    static const uint32_t requestByteLens[] = {16, 64, 1024, SpongeBufferBytes};
+    static DRBGContext bench;
+    static const uint8_t seed[32] = {0};
+    char name[64];
+    uint32_t i;
+
+    bench.buffer = malloc(SpongeBufferBytes);
+    if (bench.buffer == NULL) {
+        return;
+    }
+
+    for(i = 0; i < sizeof(requestByteLens) / sizeof(requestByteLens[0]); i++) {
+        KeccakDRBGInstantiate(&bench.drbg, 128, seed, sizeof(seed), NULL, 0);
+        bench.requestByteLen = requestByteLens[i];
+        snprintf(name, sizeof(name), "DRBG %u B requests", requestByteLens[i]);
+        Measure("drbg", name, requestByteLens[i], BenchDRBG, &bench);
+    }
+
+    KeccakDRBGErase(&bench.drbg);
+    free(bench.buffer);
+}
+
+/*
+ * NIST API
+ */
+typedef struct {
+    uint32_t hashBitLen;
+    const uint8_t * data;
+    uint64_t dataByteLen;
+} HashContext;
+
+static void BenchHash(void * context, uint64_t iterations)
+{
+    HashContext * bench = context;
+    BitSequence hashVal[64];
+    uint64_t i;
+
+    for(i = 0; i < iterations; i++) {
+        Hash(bench->hashBitLen, bench->data, bench->dataByteLen * 8, hashVal);
+        sink += hashVal[0];
+    }
+}
+
+static void RunHashBenchmarks(void)
+{
+    static const uint32_t hashBitLens[] = {256, 512};
+    HashContext bench;
+    char name[64];
+    uint64_t size;
+    uint32_t h;
+
+    uint8_t * data = NULL;
+    while(data == NULL) {
+        data = calloc(maximumMessageBytes + 1, 1);
+        if ((data == NULL) && (maximumMessageBytes > 1)) {
+            maximumMessageBytes /= 2;
+            fprintf(stderr, "Out of memory, hashing at most %llu bytes\n", (unsigned long long) maximumMessageBytes);
+        }
+    }
+
+    bench.data = data;
+
+    for(h = 0; h < sizeof(hashBitLens) / sizeof(hashBitLens[0]); h++) {
+        bench.hashBitLen = hashBitLens[h];
+
+        // 0 B, then every power of 4 from 1 B up to the maximum
+        for(size = 0; size <= maximumMessageBytes; size = (size == 0) ? 1 : size * 4) {
+            bench.dataByteLen = size;
+            snprintf(name, sizeof(name), "Hash Keccak-%u", hashBitLens[h]);
+            Measure("hash", name, size, BenchHash, &bench);
+        }
+    }
+
+    free(data);
+}
+
+/*
+ * Thread scaling
+ */
+#define ScalingMessageBytes (1 << 16)
+
+typedef struct {
+    KeccakThreadPool * pool;
+    uint32_t nrThreads;
+    const uint8_t * data;
+    uint64_t sums[256];     // One per thread, so workers write no shared location
+} ScalingContext;
+
+static void HashOneMessage(void * context, uint64_t index)
+{
+    ScalingContext * bench = context;
+    BitSequence hashVal[32];
+
+    Hash(256, bench->data, (DataLength) ScalingMessageBytes * 8, hashVal);
+    bench->sums[index] += hashVal[0];
+}
+
+static void BenchScaling(void * context, uint64_t iterations)
+{
+    ScalingContext * bench = context;
+    uint64_t i;
+
+    for(i = 0; i < iterations; i++) {
+        KeccakThreadPoolRun(bench->pool, HashOneMessage, bench, bench->nrThreads);
+    }
+    sink += bench->sums[0];
+}
+
+static void RunScalingBenchmarks(void)
+{
+    long onlineCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t maximumThreads = (onlineCPUs < 1) ? 1 : (onlineCPUs > 256) ? 256 : (uint32_t) onlineCPUs;
+    ScalingContext bench;
+    char name[64];
+    uint32_t nrThreads = 1;
+
+    bench.data = calloc(ScalingMessageBytes, 1);
+    if (bench.data == NULL) {
+        return;
+    }
+    memset(bench.sums, 0, sizeof(bench.sums));
+
+    // Powers of two, then the number of CPUs
+    while(1) {
+        bench.pool = KeccakThreadPoolCreate(nrThreads);
+        if (bench.pool == NULL) {
+            break;
+        }
+        bench.nrThreads = nrThreads;
+
+        snprintf(name, sizeof(name), "Hash Keccak-256 on %u threads", nrThreads);
+        Measure("scaling", name, (uint64_t) nrThreads * ScalingMessageBytes, BenchScaling, &bench);
+
+        KeccakThreadPoolDestroy(bench.pool);
+
+        if (nrThreads == maximumThreads) {
+            break;
+        }
+        nrThreads = (nrThreads * 2 < maximumThreads) ? nrThreads * 2 : maximumThreads;
+    }
+
+    free((void *) bench.data);
+}
+
+/*
+ * Latency of small messages
+ */
+static int CompareUint64(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static void RunLatencyBenchmarks(void)
+{
+    // Around the Keccak-256 block of 136 bytes
+    static const uint32_t sizes[] = {0, 32, 64, 135, 136, 256, 1024};
+    uint8_t data[1024];
+    BitSequence hashVal[32];
+    uint64_t buckets[nrHistogramBuckets];
+    uint32_t s, i;
+
+    uint64_t * samples = malloc(latencySamples * sizeof(uint64_t));
+    if (samples == NULL) {
+        fprintf(stderr, "Out of memory for the latency samples\n");
+        return;
+    }
+
+    memset(data, 0xA5, sizeof(data));
+
+    for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for(i = 0; i < 1000; i++) {
+            Hash(256, data, (DataLength) sizes[s] * 8, hashVal);
+        }
+
+        for(i = 0; i < latencySamples; i++) {
+            uint64_t start = ReadLatencyClock();
+            Hash(256, data, (DataLength) sizes[s] * 8, hashVal);
+            samples[i] = ReadLatencyClock() - start;
+            sink += hashVal[0];
+        }
+
+        memset(buckets, 0, sizeof(buckets));
+        for(i = 0; i < latencySamples; i++) {
+            uint32_t b = 0;
+            while((b + 1 < nrHistogramBuckets) && ((samples[i] >> (b + 1)) != 0)) {
+                b++;
+            }
+            buckets[b]++;
+        }
+
+        qsort(samples, latencySamples, sizeof(uint64_t), CompareUint64);
+
+        PrintLatency("Hash Keccak-256", sizes[s], samples, latencySamples, buckets);
+    }
+
+    free(samples);
+}
+
+static void PrintUsage(FILE * stream)
+{
+    fprintf(stream, "Usage: keccakbench [OPTION]...\n");
+    fprintf(stream, "  --format text|csv|json  output format, text by default\n");
+    fprintf(stream, "  --max-size BYTES        largest message for the Hash benchmarks, 1 GiB by default\n");
+    fprintf(stream, "  --min-time MS           minimum duration of a trial, 100 ms by default\n");
+    fprintf(stream, "  --samples N             samples per latency histogram, 100000 by default\n");
+    fprintf(stream, "  --quick                 --max-size 16777216 --min-time 20 --samples 10000\n");
+}
+
+int main(int argc, char * argv[])
+{
+    int i;
+
+    for(i = 1; i < argc; i++) {
+        const char * value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if ((strcmp(argv[i], "--format") == 0) && (value != NULL)) {
+            if (strcmp(value, "text") == 0) {
+                outputFormat = TEXT;
+            } else if (strcmp(value, "csv") == 0) {
+                outputFormat = CSV;
+            } else if (strcmp(value, "json") == 0) {
+                outputFormat = JSON;
+            } else {
+                PrintUsage(stderr);
+                return 1;
+            }
+            i++;
+        }
+        else if ((strcmp(argv[i], "--max-size") == 0) && (value != NULL)) {
+            maximumMessageBytes = strtoull(value, NULL, 10);
+            i++;
+        }
+        else if ((strcmp(argv[i], "--min-time") == 0) && (value != NULL)) {
+            minimumTrialNanoseconds = strtoull(value, NULL, 10) * 1000000;
+            i++;
+        }
+        else if ((strcmp(argv[i], "--samples") == 0) && (value != NULL)) {
+            latencySamples = (uint32_t) strtoul(value, NULL, 10);
+            latencySamples = (latencySamples > 0) ? latencySamples : 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "--quick") == 0) {
+            maximumMessageBytes = 1 << 24;
+            minimumTrialNanoseconds = 20000000;
+            latencySamples = 10000;
+        }
+        else {
+            PrintUsage((strcmp(argv[i], "--help") == 0) ? stdout : stderr);
+            return (strcmp(argv[i], "--help") == 0) ? 0 : 1;
+        }
+    }
+
+    PrintHeader();
+
+    RunPermutationBenchmarks();
+    RunSpongeBenchmarks();
+    RunDRBGBenchmarks();
+    RunHashBenchmarks();
+    RunScalingBenchmarks();
+
+    StartLatencySection();
+    RunLatencyBenchmarks();
+
+    PrintFooter();
+
+    return 0;
+}
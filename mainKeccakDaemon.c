@@ -0,0 +1,499 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+/*
+ * keccakd: a local hashing daemon
+ *
+ * Serves hash and XOF requests over a SOCK_SEQPACKET Unix domain socket, see
+ * KeccakDaemonProtocol.h. Each connection is owned by one of the workers,
+ * one per online CPU by default, which waits for its connections with epoll.
+ * A worker takes every request waiting on a connection with one recvmmsg(),
+ * up to KeccakDaemonBatch of them, and sends all the responses with one
+ * sendmmsg(), so small requests cost two system calls per batch instead of
+ * two each.
+ *
+ * A message passed as a file descriptor is never copied through the socket. A
+ * memfd sealed against shrinking is mapped and absorbed in place; any other
+ * file is read, because a client could truncate a mapped file under the
+ * worker and the access past the new end would kill the daemon with SIGBUS.
+ * Hashing a large file occupies its worker, and the other connections of
+ * that worker wait for it. Pipes and sockets are refused, since a client
+ * that never closes one would block the worker for good; for the same reason
+ * a client that does not read its responses for KeccakDaemonSendTimeout
+ * milliseconds is disconnected.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "KeccakSponge.h"
+#include "KeccakNISTInterface.h"
+#include "KeccakErase.h"
+#include "KeccakDaemonProtocol.h"
+
+// Requests taken from a connection at once
+#define KeccakDaemonBatch 32
+
+// Milliseconds a batch of responses may wait for the client to read
+#define KeccakDaemonSendTimeout 1000
+
+// Size of the buffer used to read files that are not mapped
+#define ReadBufferSize (1 << 16)
+
+#define RequestPacketSize (sizeof(KeccakDaemonRequest) + KeccakDaemonMaxInlineByteLen)
+#define ResponsePacketSize (sizeof(KeccakDaemonResponse) + KeccakDaemonMaxOutputByteLen)
+
+static const char * programName = "keccakd";
+
+static volatile sig_atomic_t stopRequested = 0;
+
+typedef struct {
+    int epoll;
+    pthread_t thread;
+
+    // Buffers of one batch
+    uint8_t * requests;         // KeccakDaemonBatch packets of RequestPacketSize bytes
+    uint8_t * responses;        // KeccakDaemonBatch packets of ResponsePacketSize bytes
+    union {
+        size_t align;           // Alignment of struct cmsghdr
+        uint8_t bytes[CMSG_SPACE(sizeof(int))];
+    } controls[KeccakDaemonBatch];
+    uint8_t readBuffer[ReadBufferSize];
+} Worker;
+
+static uint64_t ReadMilliseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+/**
+  * Absorb the whole content of a regular file passed by a client.
+  * Only a memfd sealed with F_SEAL_SHRINK is mapped, as it cannot be truncated
+  * while the worker reads the mapping.
+  * @return 0, EINVAL if the descriptor is not a regular file, or the errno of the failed read.
+  */
+static int32_t AbsorbFile(Worker * worker, SpongeState * state, int fd)
+{
+    struct stat status;
+    int seals;
+    off_t offset = 0;
+
+    if (fstat(fd, &status) != 0) {
+        return errno;
+    }
+    if (!S_ISREG(status.st_mode)) {
+        return EINVAL;
+    }
+
+    seals = fcntl(fd, F_GET_SEALS);
+    if ((seals >= 0) && (seals & F_SEAL_SHRINK) && ((uint64_t) status.st_size <= SIZE_MAX)) {
+        if (status.st_size == 0) {
+            return 0;
+        }
+
+        void * mapping = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            posix_madvise(mapping, (size_t) status.st_size, POSIX_MADV_SEQUENTIAL);
+            AbsorbBytes(state, mapping, (uint64_t) status.st_size);
+            munmap(mapping, (size_t) status.st_size);
+            return 0;
+        }
+    }
+
+    // Read from the start, since the client may pass one descriptor with many requests
+    while(1) {
+        ssize_t bytesRead = pread(fd, worker->readBuffer, sizeof(worker->readBuffer), offset);
+        if (bytesRead > 0) {
+            AbsorbBytes(state, worker->readBuffer, (uint64_t) bytesRead);
+            offset += bytesRead;
+        }
+        else if (bytesRead == 0) {
+            return 0;
+        }
+        else if (errno != EINTR) {
+            return errno;
+        }
+    }
+}
+
+/**
+  * Serve one request.
+  * @param  fd          The file descriptor passed with the request, or -1.
+  * @return 0, or an errno value for the response.
+  */
+static int32_t ServeRequest(Worker * worker, const KeccakDaemonRequest * request, const uint8_t * data,
+                            uint64_t dataByteLen, int fd, uint8_t * output)
+{
+    if (request->algorithm >= KeccakDaemonNrAlgorithms) {
+        return EINVAL;
+    }
+
+    const KeccakDaemonAlgorithmParameters * algorithm = &KeccakDaemonAlgorithms[request->algorithm];
+    uint32_t rate = 1600 - algorithm->capacity;
+
+    if ((request->outputByteLen > KeccakDaemonMaxOutputByteLen) ||
+        ((algorithm->outputByteLen != 0) && (request->outputByteLen != algorithm->outputByteLen))) {
+        return EINVAL;
+    }
+
+    if (request->flags & KeccakDaemonRequestFile) {
+        SpongeState state;
+        int32_t error;
+
+        if (fd < 0) {
+            return EBADF;
+        }
+
+        InitSponge(&state, rate, algorithm->capacity);
+        state.delimitedSuffix = algorithm->delimitedSuffix;
+
+        error = AbsorbFile(worker, &state, fd);
+        if (error == 0) {
+            Squeeze(&state, output, (uint64_t) request->outputByteLen * 8);
+        }
+
+        EraseState(&state);
+        return error;
+    }
+
+    if (algorithm->delimitedSuffix == KeccakDelimitedSuffix) {
+        return (Hash(request->outputByteLen * 8, data, dataByteLen * 8, output) == SUCCESS) ? 0 : EINVAL;
+    }
+
+    SpongeMatrix matrix;
+    SpongeOneShot(matrix, rate, algorithm->delimitedSuffix, data, dataByteLen, output, request->outputByteLen);
+    KeccakErase(&matrix, sizeof(matrix)); // Clear memory of secret data
+    return 0;
+}
+
+/**
+  * Take the file descriptors passed with a received packet. Every descriptor
+  * of every SCM_RIGHTS message is counted, and all but the first are closed.
+  * @param  nrDescriptors   Set to the number of descriptors received.
+  * @return The first descriptor, or -1 if there is none.
+  */
+static int ReceivedFileDescriptor(struct msghdr * message, uint32_t * nrDescriptors)
+{
+    struct cmsghdr * control;
+    int fd = -1;
+
+    *nrDescriptors = 0;
+    for(control = CMSG_FIRSTHDR(message); control != NULL; control = CMSG_NXTHDR(message, control)) {
+        if ((control->cmsg_level == SOL_SOCKET) && (control->cmsg_type == SCM_RIGHTS) &&
+            (control->cmsg_len >= CMSG_LEN(0))) {
+            size_t count = (control->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            size_t d;
+
+            for(d = 0; d < count; d++) {
+                int received;
+                memcpy(&received, CMSG_DATA(control) + d * sizeof(int), sizeof(int));
+
+                if (*nrDescriptors == 0) {
+                    fd = received;
+                }
+                else {
+                    close(received);
+                }
+                (*nrDescriptors)++;
+            }
+        }
+    }
+
+    return fd;
+}
+
+/**
+  * Serve every request waiting on a connection, a batch at a time.
+  * @return 0, or -1 when the connection is closed or broken.
+  */
+static int32_t ServeConnection(Worker * worker, int connection)
+{
+    struct mmsghdr messages[KeccakDaemonBatch];
+    struct mmsghdr replies[KeccakDaemonBatch];
+    struct iovec requestVectors[KeccakDaemonBatch];
+    struct iovec replyVectors[KeccakDaemonBatch];
+    uint32_t i;
+
+    while(1) {
+        memset(messages, 0, sizeof(messages));
+        for(i = 0; i < KeccakDaemonBatch; i++) {
+            requestVectors[i].iov_base = worker->requests + (size_t) i * RequestPacketSize;
+            requestVectors[i].iov_len = RequestPacketSize;
+            messages[i].msg_hdr.msg_iov = &requestVectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = worker->controls[i].bytes;
+            messages[i].msg_hdr.msg_controllen = sizeof(worker->controls[i].bytes);
+        }
+
+        int received = recvmmsg(connection, messages, KeccakDaemonBatch, MSG_DONTWAIT | MSG_CMSG_CLOEXEC, NULL);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+        }
+        if (received == 0) {
+            return -1;
+        }
+
+        uint32_t nrReplies = 0;
+        for(i = 0; i < (uint32_t) received; i++) {
+            const uint8_t * packet = requestVectors[i].iov_base;
+            uint64_t packetByteLen = messages[i].msg_len;
+            uint32_t nrDescriptors;
+            int fd = ReceivedFileDescriptor(&messages[i].msg_hdr, &nrDescriptors);
+
+            // An empty packet is the end of the connection
+            if (packetByteLen == 0) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+                break;
+            }
+
+            uint8_t * reply = worker->responses + (size_t) nrReplies * ResponsePacketSize;
+            KeccakDaemonResponse response;
+            KeccakDaemonRequest request;
+
+            memset(&request, 0, sizeof(request));
+            memcpy(&request, packet, (packetByteLen < sizeof(request)) ? packetByteLen : sizeof(request));
+
+            response.id = request.id;
+            response.outputByteLen = 0;
+
+            if ((packetByteLen < sizeof(request)) || (messages[i].msg_hdr.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+                response.status = EMSGSIZE;
+            }
+            else if (nrDescriptors > 1) {
+                response.status = EBADF;
+            }
+            else {
+                response.status = ServeRequest(worker, &request, packet + sizeof(request),
+                                               packetByteLen - sizeof(request), fd,
+                                               reply + sizeof(KeccakDaemonResponse));
+            }
+
+            if (fd >= 0) {
+                close(fd);
+            }
+
+            if (response.status == 0) {
+                response.outputByteLen = request.outputByteLen;
+            }
+            memcpy(reply, &response, sizeof(response));
+
+            replyVectors[nrReplies].iov_base = reply;
+            replyVectors[nrReplies].iov_len = sizeof(response) + response.outputByteLen;
+            memset(&replies[nrReplies], 0, sizeof(replies[nrReplies]));
+            replies[nrReplies].msg_hdr.msg_iov = &replyVectors[nrReplies];
+            replies[nrReplies].msg_hdr.msg_iovlen = 1;
+            nrReplies++;
+        }
+
+        // Send every reply of the batch, waiting up to KeccakDaemonSendTimeout for a slow client
+        uint64_t deadline = ReadMilliseconds() + KeccakDaemonSendTimeout;
+        uint32_t sent = 0;
+        while(sent < nrReplies) {
+            int count = sendmmsg(connection, replies + sent, nrReplies - sent, MSG_NOSIGNAL);
+            if (count > 0) {
+                sent += (uint32_t) count;
+            }
+            else if ((count < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+                struct pollfd writable = {connection, POLLOUT, 0};
+                uint64_t now = ReadMilliseconds();
+
+                if ((now >= deadline) || (poll(&writable, 1, (int) (deadline - now)) == 0)) {
+                    return -1;
+                }
+            }
+            else if ((count < 0) && (errno != EINTR)) {
+                return -1;
+            }
+        }
+
+        if (i < (uint32_t) received) {
+            return -1;
+        }
+        if (received < KeccakDaemonBatch) {
+            return 0;
+        }
+    }
+}
+
+static void * WorkerMain(void * argument)
+{
+    Worker * worker = argument;
+    struct epoll_event events[64];
+
+    while(1) {
+        int count = epoll_wait(worker->epoll, events, 64, -1);
+        int i;
+
+        for(i = 0; i < count; i++) {
+            int connection = events[i].data.fd;
+
+            if ((ServeConnection(worker, connection) != 0) || (events[i].events & (EPOLLHUP | EPOLLERR))) {
+                close(connection); // Also removes it from the epoll set
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void StopOnSignal(int signalNumber)
+{
+    (void) signalNumber;
+    stopRequested = 1;
+}
+
+static void PrintUsage(FILE * stream)
+{
+    fprintf(stream, "Usage: %s [OPTION]...\n", programName);
+    fprintf(stream, "Serve SHA3, Keccak and SHAKE requests on a Unix domain socket until SIGINT or SIGTERM.\n\n");
+    fprintf(stream, "  -s, --socket PATH     socket path, %s by default\n", KeccakDaemonDefaultSocket);
+    fprintf(stream, "  -w, --workers N       number of worker threads, one per online CPU by default\n");
+    fprintf(stream, "  -h, --help            print this help\n");
+}
+
+int main(int argc, char * argv[])
+{
+    const char * socketPath = KeccakDaemonDefaultSocket;
+    uint32_t nrWorkers = 0;
+    int i;
+
+    for(i = 1; i < argc; i++) {
+        const char * argument = argv[i];
+
+        if (((strcmp(argument, "-s") == 0) || (strcmp(argument, "--socket") == 0)) && (i + 1 < argc)) {
+            socketPath = argv[++i];
+        }
+        else if (((strcmp(argument, "-w") == 0) || (strcmp(argument, "--workers") == 0)) && (i + 1 < argc)) {
+            char * end;
+            unsigned long value = strtoul(argv[++i], &end, 10);
+            if ((*end != 0) || (value == 0) || (value > 1024)) {
+                fprintf(stderr, "%s: invalid number of workers '%s'\n", programName, argv[i]);
+                return 1;
+            }
+            nrWorkers = (uint32_t) value;
+        }
+        else if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "--help") == 0)) {
+            PrintUsage(stdout);
+            return 0;
+        }
+        else {
+            fprintf(stderr, "%s: unknown option '%s'\n", programName, argument);
+            PrintUsage(stderr);
+            return 1;
+        }
+    }
+
+    if (nrWorkers == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        nrWorkers = (online > 0) ? (uint32_t) online : 1;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", programName);
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    unlink(socketPath);
+    if ((listener < 0) || (bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0) ||
+        (listen(listener, 128) != 0)) {
+        fprintf(stderr, "%s: %s: %s\n", programName, socketPath, strerror(errno));
+        return 1;
+    }
+
+    // Without SA_RESTART a signal interrupts accept(), so the daemon stops promptly
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = StopOnSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    Worker * workers = calloc(nrWorkers, sizeof(Worker));
+    if (workers == NULL) {
+        fprintf(stderr, "%s: %s\n", programName, strerror(ENOMEM));
+        unlink(socketPath);
+        return 1;
+    }
+
+    // The workers block SIGINT and SIGTERM, so the signals reach the main thread and interrupt accept()
+    sigset_t stopSignals;
+    sigset_t previousMask;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previousMask);
+
+    for(i = 0; i < (int) nrWorkers; i++) {
+        workers[i].epoll = epoll_create1(EPOLL_CLOEXEC);
+        workers[i].requests = malloc(KeccakDaemonBatch * RequestPacketSize);
+        workers[i].responses = malloc(KeccakDaemonBatch * ResponsePacketSize);
+
+        if ((workers[i].epoll < 0) || (workers[i].requests == NULL) || (workers[i].responses == NULL) ||
+            (pthread_create(&workers[i].thread, NULL, WorkerMain, &workers[i]) != 0)) {
+            fprintf(stderr, "%s: cannot start worker %d\n", programName, i);
+            unlink(socketPath);
+            return 1;
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previousMask, NULL);
+
+    // Hand the connections to the workers in turn
+    uint64_t nrConnections = 0;
+    while(!stopRequested) {
+        int connection = accept4(listener, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (connection < 0) {
+            if ((errno != EINTR) && (errno != ECONNABORTED)) {
+                fprintf(stderr, "%s: accept: %s\n", programName, strerror(errno));
+            }
+            continue;
+        }
+
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = connection;
+
+        if (epoll_ctl(workers[nrConnections % nrWorkers].epoll, EPOLL_CTL_ADD, connection, &event) != 0) {
+            close(connection);
+            continue;
+        }
+        nrConnections++;
+    }
+
+    // The workers end with the process
+    close(listener);
+    unlink(socketPath);
+
+    return 0;
+}
@@ -0,0 +1,530 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+/*
+ * keccakload: load generator for keccakd
+ *
+ * Each connection runs on its own thread and keeps up to --depth requests in
+ * flight. The tool reports the throughput over all connections and percentiles
+ * of the latency of single requests, from sending a request to receiving its
+ * response. With --verify every output is checked against the library.
+ *
+ * Messages are --size bytes sent inline, with the request id in their first
+ * bytes so that no two are alike, or, with --file, the descriptor of a file
+ * passed along with every request. With --memfd the file is first copied to
+ * a sealed memfd, which keccakd maps instead of reading.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "KeccakSponge.h"
+#include "KeccakDaemonProtocol.h"
+
+static const char * programName = "keccakload";
+
+typedef struct {
+    // Options shared by every connection
+    const char * socketPath;
+    uint8_t algorithm;
+    uint32_t outputByteLen;
+    uint32_t messageByteLen;
+    uint32_t nrRequests;        // Per connection
+    uint32_t depth;
+    int fileDescriptor;         // -1 for inline messages
+    int32_t verify;
+    const uint8_t * fileOutput; // Expected output for --file --verify
+
+    // Results of one connection
+    pthread_t thread;
+    uint64_t * latencies;       // Nanoseconds, one per request
+    uint64_t failures;
+    int32_t error;              // errno of a broken connection, 0 if none
+} Connection;
+
+static uint64_t ReadNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static void FillMessage(uint8_t * message, uint32_t messageByteLen, uint32_t id)
+{
+    uint32_t i;
+    for(i = 0; i < messageByteLen; i++) {
+        message[i] = (uint8_t) ((i < 4) ? (id >> (8 * i)) : i);
+    }
+}
+
+static void HashLocally(uint8_t algorithm, const uint8_t * data, uint64_t dataByteLen,
+                        uint8_t * output, uint32_t outputByteLen)
+{
+    const KeccakDaemonAlgorithmParameters * parameters = &KeccakDaemonAlgorithms[algorithm];
+    SpongeMatrix matrix;
+
+    SpongeOneShot(matrix, 1600 - parameters->capacity, parameters->delimitedSuffix,
+                  data, dataByteLen, output, outputByteLen);
+}
+
+/**
+  * Hash a whole file as keccakd would.
+  * @return 0, or the errno of the failed read.
+  */
+static int32_t HashFileLocally(uint8_t algorithm, int fd, uint8_t * output, uint32_t outputByteLen)
+{
+    const KeccakDaemonAlgorithmParameters * parameters = &KeccakDaemonAlgorithms[algorithm];
+    static uint8_t buffer[1 << 16];
+    SpongeState state;
+    off_t offset = 0;
+
+    InitSponge(&state, 1600 - parameters->capacity, parameters->capacity);
+    state.delimitedSuffix = parameters->delimitedSuffix;
+
+    while(1) {
+        ssize_t bytesRead = pread(fd, buffer, sizeof(buffer), offset);
+        if (bytesRead > 0) {
+            AbsorbBytes(&state, buffer, (uint64_t) bytesRead);
+            offset += bytesRead;
+        }
+        else if (bytesRead == 0) {
+            break;
+        }
+        else if (errno != EINTR) {
+            return errno;
+        }
+    }
+
+    Squeeze(&state, output, (uint64_t) outputByteLen * 8);
+    return 0;
+}
+
+/**
+  * Copy a file to a memfd sealed against any change, and close the file.
+  * @return The memfd, or -1.
+  */
+static int CopyToSealedMemfd(int fd)
+{
+    static uint8_t buffer[1 << 16];
+    int memfd = memfd_create("keccakload", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    ssize_t bytesRead;
+
+    if (memfd < 0) {
+        close(fd);
+        return -1;
+    }
+
+    while((bytesRead = read(fd, buffer, sizeof(buffer))) != 0) {
+        if ((bytesRead < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if ((bytesRead < 0) || (write(memfd, buffer, (size_t) bytesRead) != bytesRead)) {
+            close(memfd);
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+
+    if (fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        close(memfd);
+        return -1;
+    }
+    return memfd;
+}
+
+/**
+  * Send one request without blocking.
+  * @return 1 if sent, 0 if the socket is full, -1 on error.
+  */
+static int32_t SendRequest(Connection * connection, int socketFd, uint32_t id, uint8_t * packet)
+{
+    KeccakDaemonRequest request;
+    struct msghdr message;
+    struct iovec vector;
+    union {
+        size_t align;           // Alignment of struct cmsghdr
+        uint8_t bytes[CMSG_SPACE(sizeof(int))];
+    } control;
+    size_t packetByteLen = sizeof(request);
+
+    memset(&request, 0, sizeof(request));
+    request.id = id;
+    request.algorithm = connection->algorithm;
+    request.outputByteLen = connection->outputByteLen;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+
+    if (connection->fileDescriptor >= 0) {
+        request.flags = KeccakDaemonRequestFile;
+
+        memset(&control, 0, sizeof(control));
+        message.msg_control = control.bytes;
+        message.msg_controllen = sizeof(control.bytes);
+
+        struct cmsghdr * header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(header), &connection->fileDescriptor, sizeof(int));
+    }
+    else {
+        FillMessage(packet + sizeof(request), connection->messageByteLen, id);
+        packetByteLen += connection->messageByteLen;
+    }
+
+    memcpy(packet, &request, sizeof(request));
+    vector.iov_base = packet;
+    vector.iov_len = packetByteLen;
+
+    if (sendmsg(socketFd, &message, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0) {
+        return 1;
+    }
+    return ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ? 0 : -1;
+}
+
+/**
+  * Check a response against the expected output.
+  * @return 1 if the response is wrong.
+  */
+static uint32_t CheckResponse(Connection * connection, const uint8_t * packet, ssize_t packetByteLen, uint32_t id,
+                              uint8_t * message, uint8_t * expected)
+{
+    KeccakDaemonResponse response;
+
+    if (packetByteLen < (ssize_t) sizeof(response)) {
+        return 1;
+    }
+    memcpy(&response, packet, sizeof(response));
+
+    if ((response.id != id) || (response.status != 0) || (response.outputByteLen != connection->outputByteLen) ||
+        (packetByteLen != (ssize_t) (sizeof(response) + response.outputByteLen))) {
+        return 1;
+    }
+
+    if (connection->verify) {
+        if (connection->fileDescriptor >= 0) {
+            memcpy(expected, connection->fileOutput, connection->outputByteLen);
+        }
+        else {
+            FillMessage(message, connection->messageByteLen, id);
+            HashLocally(connection->algorithm, message, connection->messageByteLen, expected, connection->outputByteLen);
+        }
+        return memcmp(packet + sizeof(response), expected, connection->outputByteLen) != 0;
+    }
+
+    return 0;
+}
+
+static void * ConnectionMain(void * argument)
+{
+    Connection * connection = argument;
+    uint8_t * requestPacket = malloc(sizeof(KeccakDaemonRequest) + KeccakDaemonMaxInlineByteLen);
+    uint8_t * responsePacket = malloc(sizeof(KeccakDaemonResponse) + KeccakDaemonMaxOutputByteLen);
+    uint8_t * message = malloc(KeccakDaemonMaxInlineByteLen);
+    uint8_t * expected = malloc(KeccakDaemonMaxOutputByteLen);
+    uint64_t * sendTimes = malloc(connection->depth * sizeof(uint64_t));
+    struct sockaddr_un address;
+    uint32_t sent = 0;
+    uint32_t completed = 0;
+
+    if ((requestPacket == NULL) || (responsePacket == NULL) || (message == NULL) || (expected == NULL) ||
+        (sendTimes == NULL)) {
+        connection->error = ENOMEM;
+        goto done;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, connection->socketPath, sizeof(address.sun_path) - 1);
+
+    int socketFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if ((socketFd < 0) || (connect(socketFd, (struct sockaddr *) &address, sizeof(address)) != 0)) {
+        connection->error = errno;
+        if (socketFd >= 0) {
+            close(socketFd);
+        }
+        goto done;
+    }
+
+    // Send while fewer than depth requests are in flight, and take responses as they come
+    while(completed < connection->nrRequests) {
+        int32_t canSend = (sent < connection->nrRequests) && (sent - completed < connection->depth);
+        struct pollfd events = {socketFd, (short) (POLLIN | (canSend ? POLLOUT : 0)), 0};
+
+        if ((poll(&events, 1, -1) < 0) && (errno != EINTR)) {
+            connection->error = errno;
+            break;
+        }
+
+        if (canSend && (events.revents & POLLOUT)) {
+            sendTimes[sent % connection->depth] = ReadNanoseconds();
+
+            int32_t result = SendRequest(connection, socketFd, sent, requestPacket);
+            if (result < 0) {
+                connection->error = errno;
+                break;
+            }
+            sent += (uint32_t) result;
+        }
+
+        if (events.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t received = recv(socketFd, responsePacket, sizeof(KeccakDaemonResponse) + KeccakDaemonMaxOutputByteLen,
+                                    MSG_DONTWAIT);
+            if (received > 0) {
+                connection->latencies[completed] = ReadNanoseconds() - sendTimes[completed % connection->depth];
+                connection->failures += CheckResponse(connection, responsePacket, received, completed, message, expected);
+                completed++;
+            }
+            else if ((received == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+                connection->error = (received == 0) ? ECONNRESET : errno;
+                break;
+            }
+        }
+    }
+
+    close(socketFd);
+
+done:
+    connection->failures += connection->nrRequests - completed;
+    free(requestPacket);
+    free(responsePacket);
+    free(message);
+    free(expected);
+    free(sendTimes);
+    return NULL;
+}
+
+static int CompareUint64(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static void PrintUsage(FILE * stream)
+{
+    uint32_t i;
+
+    fprintf(stream, "Usage: %s [OPTION]...\n", programName);
+    fprintf(stream, "Send requests to keccakd and report throughput and latency.\n\n");
+    fprintf(stream, "  -s, --socket PATH       socket path, %s by default\n", KeccakDaemonDefaultSocket);
+    fprintf(stream, "  -a, --algorithm NAME    hash function, sha3-256 by default:\n                         ");
+    for(i = 0; i < KeccakDaemonNrAlgorithms; i++) {
+        fprintf(stream, " %s", KeccakDaemonAlgorithms[i].name);
+    }
+    fprintf(stream, "\n");
+    fprintf(stream, "  -l, --length BYTES      output length for shake128 and shake256, 32 by default\n");
+    fprintf(stream, "  -c, --connections N     concurrent connections, 4 by default\n");
+    fprintf(stream, "  -n, --requests N        requests per connection, 100000 by default\n");
+    fprintf(stream, "  -d, --depth N           requests in flight per connection, 16 by default\n");
+    fprintf(stream, "  -b, --size BYTES        size of the inline messages, 64 by default\n");
+    fprintf(stream, "  -f, --file PATH         pass the descriptor of PATH instead of inline messages\n");
+    fprintf(stream, "      --memfd             copy the file to a sealed memfd and pass that instead\n");
+    fprintf(stream, "      --verify            check every output against the library\n");
+    fprintf(stream, "  -h, --help              print this help\n");
+}
+
+/**
+  * Parse a number option between 1 and @a maximum.
+  * @return The value, or 0 after printing an error.
+  */
+static uint32_t ParseCount(const char * text, uint32_t maximum)
+{
+    char * end;
+    unsigned long value = strtoul(text, &end, 10);
+
+    if ((*end != 0) || (value == 0) || (value > maximum)) {
+        fprintf(stderr, "%s: invalid number '%s'\n", programName, text);
+        return 0;
+    }
+    return (uint32_t) value;
+}
+
+int main(int argc, char * argv[])
+{
+    static uint8_t fileOutput[KeccakDaemonMaxOutputByteLen];
+    Connection options;
+    uint32_t nrConnections = 4;
+    uint32_t outputByteLen = 0;
+    const char * filePath = NULL;
+    int32_t useMemfd = 0;
+    int i;
+
+    memset(&options, 0, sizeof(options));
+    options.socketPath = KeccakDaemonDefaultSocket;
+    options.algorithm = KeccakDaemonSHA3_256;
+    options.messageByteLen = 64;
+    options.nrRequests = 100000;
+    options.depth = 16;
+    options.fileDescriptor = -1;
+
+    for(i = 1; i < argc; i++) {
+        const char * argument = argv[i];
+        int32_t hasValue = (i + 1 < argc);
+
+        if (((strcmp(argument, "-s") == 0) || (strcmp(argument, "--socket") == 0)) && hasValue) {
+            options.socketPath = argv[++i];
+        }
+        else if (((strcmp(argument, "-a") == 0) || (strcmp(argument, "--algorithm") == 0)) && hasValue) {
+            uint32_t a;
+            i++;
+            for(a = 0; (a < KeccakDaemonNrAlgorithms) && (strcasecmp(argv[i], KeccakDaemonAlgorithms[a].name) != 0); a++);
+            if (a == KeccakDaemonNrAlgorithms) {
+                fprintf(stderr, "%s: unknown algorithm '%s'\n", programName, argv[i]);
+                return 1;
+            }
+            options.algorithm = (uint8_t) a;
+        }
+        else if (((strcmp(argument, "-l") == 0) || (strcmp(argument, "--length") == 0)) && hasValue) {
+            if ((outputByteLen = ParseCount(argv[++i], KeccakDaemonMaxOutputByteLen)) == 0) {
+                return 1;
+            }
+        }
+        else if (((strcmp(argument, "-c") == 0) || (strcmp(argument, "--connections") == 0)) && hasValue) {
+            if ((nrConnections = ParseCount(argv[++i], 4096)) == 0) {
+                return 1;
+            }
+        }
+        else if (((strcmp(argument, "-n") == 0) || (strcmp(argument, "--requests") == 0)) && hasValue) {
+            if ((options.nrRequests = ParseCount(argv[++i], UINT32_MAX)) == 0) {
+                return 1;
+            }
+        }
+        else if (((strcmp(argument, "-d") == 0) || (strcmp(argument, "--depth") == 0)) && hasValue) {
+            if ((options.depth = ParseCount(argv[++i], 4096)) == 0) {
+                return 1;
+            }
+        }
+        else if (((strcmp(argument, "-b") == 0) || (strcmp(argument, "--size") == 0)) && hasValue) {
+            char * end;
+            unsigned long value = strtoul(argv[++i], &end, 10);
+            if ((*end != 0) || (value > KeccakDaemonMaxInlineByteLen)) {
+                fprintf(stderr, "%s: invalid size '%s'\n", programName, argv[i]);
+                return 1;
+            }
+            options.messageByteLen = (uint32_t) value;
+        }
+        else if (((strcmp(argument, "-f") == 0) || (strcmp(argument, "--file") == 0)) && hasValue) {
+            filePath = argv[++i];
+        }
+        else if (strcmp(argument, "--memfd") == 0) {
+            useMemfd = 1;
+        }
+        else if (strcmp(argument, "--verify") == 0) {
+            options.verify = 1;
+        }
+        else if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "--help") == 0)) {
+            PrintUsage(stdout);
+            return 0;
+        }
+        else {
+            fprintf(stderr, "%s: unknown option '%s'\n", programName, argument);
+            PrintUsage(stderr);
+            return 1;
+        }
+    }
+
+    // Fixed-length functions always give their digest length
+    if (KeccakDaemonAlgorithms[options.algorithm].outputByteLen != 0) {
+        options.outputByteLen = KeccakDaemonAlgorithms[options.algorithm].outputByteLen;
+    }
+    else {
+        options.outputByteLen = (outputByteLen != 0) ? outputByteLen : 32;
+    }
+
+    if (filePath != NULL) {
+        options.fileDescriptor = open(filePath, O_RDONLY | O_CLOEXEC);
+        if (options.fileDescriptor < 0) {
+            fprintf(stderr, "%s: %s: %s\n", programName, filePath, strerror(errno));
+            return 1;
+        }
+        if (useMemfd && ((options.fileDescriptor = CopyToSealedMemfd(options.fileDescriptor)) < 0)) {
+            fprintf(stderr, "%s: %s: %s\n", programName, filePath, strerror(errno));
+            return 1;
+        }
+        if (options.verify && (HashFileLocally(options.algorithm, options.fileDescriptor,
+                                               fileOutput, options.outputByteLen) != 0)) {
+            fprintf(stderr, "%s: %s: %s\n", programName, filePath, strerror(errno));
+            return 1;
+        }
+        options.fileOutput = fileOutput;
+    }
+
+    Connection * connections = calloc(nrConnections, sizeof(Connection));
+    uint64_t * latencies = calloc((uint64_t) nrConnections * options.nrRequests, sizeof(uint64_t));
+    if ((connections == NULL) || (latencies == NULL)) {
+        fprintf(stderr, "%s: %s\n", programName, strerror(ENOMEM));
+        return 1;
+    }
+
+    uint64_t start = ReadNanoseconds();
+
+    uint32_t c;
+    for(c = 0; c < nrConnections; c++) {
+        connections[c] = options;
+        connections[c].latencies = latencies + (uint64_t) c * options.nrRequests;
+        if (pthread_create(&connections[c].thread, NULL, ConnectionMain, &connections[c]) != 0) {
+            fprintf(stderr, "%s: cannot start connection %u\n", programName, c);
+            return 1;
+        }
+    }
+
+    uint64_t failures = 0;
+    int32_t error = 0;
+    for(c = 0; c < nrConnections; c++) {
+        pthread_join(connections[c].thread, NULL);
+        failures += connections[c].failures;
+        if (connections[c].error != 0) {
+            error = connections[c].error;
+        }
+    }
+
+    uint64_t elapsed = ReadNanoseconds() - start;
+    uint64_t total = (uint64_t) nrConnections * options.nrRequests;
+    uint64_t bytesPerRequest = options.messageByteLen;
+
+    if (options.fileDescriptor >= 0) {
+        off_t size = lseek(options.fileDescriptor, 0, SEEK_END);
+        bytesPerRequest = (size > 0) ? (uint64_t) size : 0;
+    }
+
+    if (error != 0) {
+        fprintf(stderr, "%s: %s: %s\n", programName, options.socketPath, strerror(error));
+    }
+
+    qsort(latencies, total, sizeof(uint64_t), CompareUint64);
+
+    double seconds = (double) elapsed / 1e9;
+    printf("%s, %u bytes per request, %u connections, %u in flight each\n",
+           KeccakDaemonAlgorithms[options.algorithm].name, (uint32_t) bytesPerRequest, nrConnections, options.depth);
+    printf("requests   %llu in %.3f s, %llu failed\n",
+           (unsigned long long) total, seconds, (unsigned long long) failures);
+    printf("throughput %.0f requests/s, %.1f MB/s\n",
+           (double) total / seconds, (double) total * (double) bytesPerRequest / seconds / 1e6);
+    printf("latency    p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+           latencies[total * 50 / 100] / 1e3, latencies[total * 90 / 100] / 1e3, latencies[total * 99 / 100] / 1e3,
+           latencies[total * 999 / 1000] / 1e3, latencies[total - 1] / 1e3);
+
+    free(latencies);
+    free(connections);
+
+    return ((failures > 0) || (error != 0)) ? 1 : 0;
+}
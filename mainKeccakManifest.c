@@ -0,0 +1,1182 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+/*
+ * keccakmanifest: write or check the manifest of a directory tree
+ *
+ * The manifest lists every regular file under the root, sorted by path in byte
+ * order, in the format of keccaksum:
+ *   <hex digest>  <path relative to the root>
+ * so it can also be checked with keccaksum --check from the root. The order,
+ * and so the manifest, does not depend on the number of threads.
+ *
+ * The tree is walked first, then the files are hashed by a fixed set of
+ * workers, each with its own sponge state, scratch matrix and read buffer:
+ * - Files up to SmallFileByteLen are grouped into batches of up to
+ *   BatchMaxFiles files and BatchByteLen bytes. Each file of a batch is read
+ *   into the buffer of the worker and hashed with SpongeOneShot() on the
+ *   matrix of the worker, so a tree of many small files costs one task per
+ *   batch, not per file, and no allocation.
+ * - Larger files are tasks of their own, absorbed by the sponge state of the
+ *   worker. They are queued before the batches, largest first, so that a big
+ *   file does not start last.
+ * The tasks are dealt round-robin to one deque per worker. A worker takes
+ * tasks from the front of its own deque; once it is empty, it steals the back
+ * half of the deque of another worker.
+ *
+ * With -a parallelhash256 the digests are ParallelHash256 (SP 800-185, with
+ * 8192-byte chunks and no customization string) instead of SHA3-256. Their
+ * chunks are independent, so files of at least --split-size bytes are hashed
+ * one at a time after the other files, each spread over all the threads. A
+ * SHA3-256 digest cannot be split that way: a large file is hashed by one
+ * worker while the others go on with the rest of the tree.
+ *
+ * With --cache FILE, the size, modification time and digest of every file are
+ * kept in FILE, and a file whose size and modification time have not changed
+ * since the last run is not read again. Files modified within
+ * RacyMarginSeconds before a run are always hashed by the next one, as a later
+ * change in the same clock tick would not show in the modification time.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "KeccakFIPS202.h"
+#include "KeccakSponge.h"
+#include "KeccakThreadPool.h"
+#include "KeccakTreeHash.h"
+
+#define DigestByteLen 32
+#define SHA3_256Rate 1088
+
+// Files up to this size are read into the buffer of a worker and hashed in batches
+#define SmallFileByteLen (64 * 1024)
+
+// Largest number of bytes and of files in one batch
+#define BatchByteLen (1 << 20)
+#define BatchMaxFiles 64
+
+// Chunk size B of ParallelHash256
+#define ParallelHashBlockByteLen 8192
+
+// Default size from which a ParallelHash256 file is spread over all the threads
+#define DefaultSplitByteLen (8 << 20)
+
+#define MaximumThreads 256
+
+// Files modified this close to the start of the run that wrote the cache are hashed again
+#define RacyMarginSeconds 1
+
+typedef enum {
+    ManifestSHA3_256,
+    ManifestParallelHash256,
+} ManifestAlgorithm;
+
+static const char * AlgorithmNames[] = {"sha3-256", "parallelhash256"};
+
+#define nrAlgorithms (sizeof(AlgorithmNames) / sizeof(AlgorithmNames[0]))
+
+typedef struct {
+    char * path;                // Relative to the root
+    uint64_t size;
+    int64_t mtimeSeconds;
+    int64_t mtimeNanoseconds;
+    uint8_t digest[DigestByteLen];
+    int32_t error;              // errno of the failed open or read, 0 if none
+    int32_t cached;             // 1 if the digest was taken from the cache
+} ManifestFile;
+
+// Files listed in order[first .. first+count)
+typedef struct {
+    size_t first;
+    uint32_t count;
+} ManifestTask;
+
+// Tasks taskOrder[begin .. end) not taken yet
+typedef struct {
+    pthread_mutex_t lock;
+    size_t begin;
+    size_t end;
+} TaskDeque;
+
+typedef struct Manifest Manifest;
+
+typedef struct {
+    Manifest * manifest;
+    uint32_t index;
+    pthread_t thread;
+    SpongeState state;
+    SpongeMatrix matrix;        // Scratch space of SpongeOneShot()
+    uint8_t * buffer;           // BatchByteLen bytes, for small files and SHA3-256 large ones
+    uint64_t filesHashed;
+    uint64_t bytesHashed;
+    uint64_t steals;
+} ManifestWorker;
+
+struct Manifest {
+    ManifestAlgorithm algorithm;
+    int rootFd;
+
+    ManifestFile * files;       // Sorted by path
+    size_t nrFiles;
+
+    size_t * order;             // Indices of files, grouped by task
+    ManifestTask * tasks;
+    size_t nrTasks;
+    size_t * taskOrder;         // Indices of tasks, grouped by deque
+
+    TaskDeque * deques;
+    ManifestWorker * workers;
+    uint32_t nrWorkers;
+};
+
+static const char * programName = "keccakmanifest";
+
+/*
+ * Tree walk
+ *
+ * nftw() has no context argument, so the walk appends to these.
+ */
+static ManifestFile * walkFiles;
+static size_t walkNrFiles;
+static size_t walkCapacity;
+static size_t walkRootLength;
+static int32_t walkError;
+
+static int WalkEntry(const char * path, const struct stat * status, int type, struct FTW * position)
+{
+    if (position->level == 0) {
+        walkRootLength = strlen(path);
+        return 0;
+    }
+
+    if ((type == FTW_DNR) || (type == FTW_NS)) {
+        fprintf(stderr, "%s: %s: cannot read\n", programName, path);
+        walkError = 1;
+        return 0;
+    }
+    if ((type != FTW_F) || !S_ISREG(status->st_mode)) {
+        return 0;
+    }
+
+    if (walkNrFiles == walkCapacity) {
+        size_t capacity = (walkCapacity == 0) ? 1024 : 2 * walkCapacity;
+        ManifestFile * files = realloc(walkFiles, capacity * sizeof(ManifestFile));
+        if (files == NULL) {
+            return ENOMEM;
+        }
+        walkFiles = files;
+        walkCapacity = capacity;
+    }
+
+    const char * relative = path + walkRootLength;
+    while(*relative == '/') {
+        relative++;
+    }
+
+    ManifestFile * file = &walkFiles[walkNrFiles];
+    memset(file, 0, sizeof(ManifestFile));
+    file->path = strdup(relative);
+    if (file->path == NULL) {
+        return ENOMEM;
+    }
+    file->size = (uint64_t) status->st_size;
+    file->mtimeSeconds = (int64_t) status->st_mtim.tv_sec;
+    file->mtimeNanoseconds = (int64_t) status->st_mtim.tv_nsec;
+    walkNrFiles++;
+
+    return 0;
+}
+
+static int CompareFiles(const void * a, const void * b)
+{
+    return strcmp(((const ManifestFile *) a)->path, ((const ManifestFile *) b)->path);
+}
+
+/**
+  * List the regular files under @a root, sorted by path. Symbolic links are not followed.
+  * @return 0, or 1 after printing an error; unreadable directories are reported but not fatal.
+  */
+static int32_t WalkTree(const char * root, ManifestFile ** files, size_t * nrFiles, int32_t * unreadable)
+{
+    walkFiles = NULL;
+    walkNrFiles = 0;
+    walkCapacity = 0;
+    walkError = 0;
+
+    int result = nftw(root, WalkEntry, 64, FTW_PHYS);
+    if (result != 0) {
+        fprintf(stderr, "%s: %s: %s\n", programName, root, strerror((result > 0) ? result : errno));
+        return 1;
+    }
+
+    qsort(walkFiles, walkNrFiles, sizeof(ManifestFile), CompareFiles);
+
+    *files = walkFiles;
+    *nrFiles = walkNrFiles;
+    *unreadable = walkError;
+    return 0;
+}
+
+/**
+  * Read up to @a length bytes from @a fd.
+  * @return The number of bytes read, which is less than @a length only if the file shrank, or -1.
+  */
+static int64_t ReadFully(int fd, uint8_t * buffer, uint64_t length)
+{
+    uint64_t done = 0;
+
+    while(done < length) {
+        ssize_t bytesRead = read(fd, buffer + done, length - done);
+        if (bytesRead > 0) {
+            done += (uint64_t) bytesRead;
+        }
+        else if ((bytesRead < 0) && (errno == EINTR)) {
+            continue;
+        }
+        else if (bytesRead == 0) {
+            break;
+        }
+        else {
+            return -1;
+        }
+    }
+    return (int64_t) done;
+}
+
+static int OpenFile(const Manifest * manifest, const ManifestFile * file)
+{
+    return openat(manifest->rootFd, file->path, O_RDONLY | O_NOFOLLOW);
+}
+
+/**
+  * Hash a large file, read through the buffer of @a worker into the sponge state of the worker,
+  * or read whole and hashed with ParallelHash256 spread over @a pool. The file is read rather
+  * than mapped, as a file of the tree truncated while mapped would kill the run with SIGBUS.
+  */
+static void HashLargeFile(const Manifest * manifest, ManifestWorker * worker, ManifestFile * file, KeccakThreadPool * pool)
+{
+    struct stat status;
+    int fd = OpenFile(manifest, file);
+    if (fd < 0) {
+        file->error = errno;
+        return;
+    }
+
+    // Read the file as it is now, which may differ from what the walk saw
+    if (fstat(fd, &status) != 0) {
+        file->error = errno;
+        close(fd);
+        return;
+    }
+    file->size = (uint64_t) status.st_size;
+    file->mtimeSeconds = (int64_t) status.st_mtim.tv_sec;
+    file->mtimeNanoseconds = (int64_t) status.st_mtim.tv_nsec;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (manifest->algorithm == ManifestSHA3_256) {
+        uint64_t totalRead = 0;
+        int64_t bytesRead;
+
+        InitSHA3(&worker->state, 256);
+        while((bytesRead = ReadFully(fd, worker->buffer, BatchByteLen)) > 0) {
+            AbsorbBytes(&worker->state, worker->buffer, (uint64_t) bytesRead);
+            totalRead += (uint64_t) bytesRead;
+        }
+        if (bytesRead < 0) {
+            file->error = errno;
+        }
+        else {
+            Squeeze(&worker->state, file->digest, 256);
+            file->size = totalRead;
+        }
+    }
+    else {
+        // ParallelHash256 needs the whole file at once
+        uint8_t * data = (file->size <= SIZE_MAX) ? malloc((file->size > 0) ? (size_t) file->size : 1) : NULL;
+        int64_t bytesRead = (data != NULL) ? ReadFully(fd, data, file->size) : -1;
+
+        if (data == NULL) {
+            file->error = ENOMEM;
+        }
+        else if (bytesRead < 0) {
+            file->error = errno;
+        }
+        else {
+            ParallelHash256(data, (uint64_t) bytesRead, ParallelHashBlockByteLen, NULL, 0, file->digest, 256, pool);
+            file->size = (uint64_t) bytesRead;
+        }
+        free(data);
+    }
+
+    close(fd);
+
+    if (file->error == 0) {
+        worker->filesHashed++;
+        worker->bytesHashed += file->size;
+    }
+}
+
+/**
+  * Read the small files of a batch one after the other into the buffer of @a worker and hash them.
+  * Each file is read to its end, and its size and modification time are updated to what was hashed.
+  */
+static void HashBatchOfFiles(const Manifest * manifest, ManifestWorker * worker, const ManifestTask * task)
+{
+    uint32_t i;
+
+    for(i = 0; i < task->count; i++) {
+        ManifestFile * file = &manifest->files[manifest->order[task->first + i]];
+        struct stat status;
+        int fd = OpenFile(manifest, file);
+        if (fd < 0) {
+            file->error = errno;
+            continue;
+        }
+
+        // Read to the end of the file as it is now, which may differ from what the walk saw
+        if (fstat(fd, &status) != 0) {
+            file->error = errno;
+            close(fd);
+            continue;
+        }
+        int64_t bytesRead = ReadFully(fd, worker->buffer, BatchByteLen);
+        close(fd);
+        if (bytesRead < 0) {
+            file->error = errno;
+            continue;
+        }
+        file->mtimeSeconds = (int64_t) status.st_mtim.tv_sec;
+        file->mtimeNanoseconds = (int64_t) status.st_mtim.tv_nsec;
+
+        // A file that grew past the buffer is hashed as a large one
+        if (bytesRead == BatchByteLen) {
+            HashLargeFile(manifest, worker, file, NULL);
+            continue;
+        }
+        file->size = (uint64_t) bytesRead;
+
+        const uint8_t * data = worker->buffer;
+        if (manifest->algorithm == ManifestSHA3_256) {
+            SpongeOneShot(worker->matrix, SHA3_256Rate, SHA3DelimitedSuffix, data, (uint64_t) bytesRead,
+                          file->digest, DigestByteLen);
+        }
+        else {
+            ParallelHash256(data, (uint64_t) bytesRead, ParallelHashBlockByteLen, NULL, 0, file->digest, 256, NULL);
+        }
+
+        worker->filesHashed++;
+        worker->bytesHashed += (uint64_t) bytesRead;
+    }
+}
+
+static void RunTask(Manifest * manifest, ManifestWorker * worker, size_t taskIndex)
+{
+    const ManifestTask * task = &manifest->tasks[taskIndex];
+    ManifestFile * first = &manifest->files[manifest->order[task->first]];
+
+    if ((task->count == 1) && (first->size > SmallFileByteLen)) {
+        HashLargeFile(manifest, worker, first, NULL);
+    }
+    else {
+        HashBatchOfFiles(manifest, worker, task);
+    }
+}
+
+/*
+ * Work stealing
+ *
+ * Each deque is a range of taskOrder. The owner takes the task at the front.
+ * A thief moves the back half of a victim's range to its own deque, which is
+ * empty at that point, so the tasks never move in memory. Tasks are only ever
+ * removed, so a worker that finds every deque empty is done.
+ */
+static int32_t TakeTask(Manifest * manifest, uint32_t self, size_t * task)
+{
+    TaskDeque * deque = &manifest->deques[self];
+    int32_t found = 0;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->begin < deque->end) {
+        *task = manifest->taskOrder[deque->begin++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return found;
+}
+
+static int32_t StealTasks(Manifest * manifest, uint32_t self, size_t * task)
+{
+    uint32_t i;
+
+    for(i = 1; i < manifest->nrWorkers; i++) {
+        TaskDeque * victim = &manifest->deques[(self + i) % manifest->nrWorkers];
+        size_t begin = 0;
+        size_t end = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->begin < victim->end) {
+            size_t stolen = (victim->end - victim->begin + 1) / 2;
+            end = victim->end;
+            begin = end - stolen;
+            victim->end = begin;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end) {
+            TaskDeque * own = &manifest->deques[self];
+
+            *task = manifest->taskOrder[begin];
+            pthread_mutex_lock(&own->lock);
+            own->begin = begin + 1;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+
+            manifest->workers[self].steals++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void * WorkerMain(void * argument)
+{
+    ManifestWorker * worker = argument;
+    Manifest * manifest = worker->manifest;
+    size_t task;
+
+    while(TakeTask(manifest, worker->index, &task) || StealTasks(manifest, worker->index, &task)) {
+        RunTask(manifest, worker, task);
+    }
+    return NULL;
+}
+
+static const ManifestFile * sortFiles;
+
+static int CompareBySizeDescending(const void * a, const void * b)
+{
+    uint64_t sizeA = sortFiles[*(const size_t *) a].size;
+    uint64_t sizeB = sortFiles[*(const size_t *) b].size;
+
+    if (sizeA != sizeB) {
+        return (sizeA > sizeB) ? -1 : 1;
+    }
+    // Keep path order among files of one size
+    return (*(const size_t *) a < *(const size_t *) b) ? -1 : 1;
+}
+
+/**
+  * Group the files that still need hashing, and are not split, into tasks and deal them to the deques.
+  * @return 0, or ENOMEM.
+  */
+static int32_t ScheduleTasks(Manifest * manifest, const int32_t * pending)
+{
+    size_t nrLarge = 0;
+    size_t nrOrdered = 0;
+    size_t i;
+
+    manifest->order = malloc((manifest->nrFiles + 1) * sizeof(size_t));
+    manifest->tasks = malloc((manifest->nrFiles + 1) * sizeof(ManifestTask));
+    manifest->taskOrder = malloc((manifest->nrFiles + 1) * sizeof(size_t));
+    if ((manifest->order == NULL) || (manifest->tasks == NULL) || (manifest->taskOrder == NULL)) {
+        return ENOMEM;
+    }
+    manifest->nrTasks = 0;
+
+    // Large files first, largest first, one task each
+    for(i = 0; i < manifest->nrFiles; i++) {
+        if (pending[i] && (manifest->files[i].size > SmallFileByteLen)) {
+            manifest->order[nrLarge++] = i;
+        }
+    }
+    sortFiles = manifest->files;
+    qsort(manifest->order, nrLarge, sizeof(size_t), CompareBySizeDescending);
+    for(nrOrdered = 0; nrOrdered < nrLarge; nrOrdered++) {
+        manifest->tasks[manifest->nrTasks].first = nrOrdered;
+        manifest->tasks[manifest->nrTasks].count = 1;
+        manifest->nrTasks++;
+    }
+
+    // Then the small files in path order, so a batch mostly reads one directory
+    ManifestTask * batch = NULL;
+    uint64_t batchBytes = 0;
+    for(i = 0; i < manifest->nrFiles; i++) {
+        if (!pending[i] || (manifest->files[i].size > SmallFileByteLen)) {
+            continue;
+        }
+        if ((batch == NULL) || (batch->count == BatchMaxFiles) ||
+            (batchBytes + manifest->files[i].size > BatchByteLen)) {
+            batch = &manifest->tasks[manifest->nrTasks++];
+            batch->first = nrOrdered;
+            batch->count = 0;
+            batchBytes = 0;
+        }
+        manifest->order[nrOrdered++] = i;
+        batch->count++;
+        batchBytes += manifest->files[i].size;
+    }
+
+    // Deal the tasks round-robin: deque w holds tasks w, w + nrWorkers, ...
+    size_t position = 0;
+    uint32_t w;
+    for(w = 0; w < manifest->nrWorkers; w++) {
+        manifest->deques[w].begin = position;
+        for(i = w; i < manifest->nrTasks; i += manifest->nrWorkers) {
+            manifest->taskOrder[position++] = i;
+        }
+        manifest->deques[w].end = position;
+    }
+
+    return 0;
+}
+
+/**
+  * Hash the files flagged in @a pending on the workers of @a manifest.
+  * @return 0, or ENOMEM.
+  */
+static int32_t HashFiles(Manifest * manifest, const int32_t * pending)
+{
+    int32_t error = ScheduleTasks(manifest, pending);
+    uint32_t started = 0;
+    uint32_t w;
+
+    if (error != 0) {
+        return error;
+    }
+
+    for(w = 0; w < manifest->nrWorkers; w++) {
+        if (pthread_create(&manifest->workers[w].thread, NULL, WorkerMain, &manifest->workers[w]) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    // The tasks of a worker that could not start are stolen by the others, or run here
+    if (started == 0) {
+        WorkerMain(&manifest->workers[0]);
+    }
+    for(w = 0; w < started; w++) {
+        pthread_join(manifest->workers[w].thread, NULL);
+    }
+
+    return 0;
+}
+
+/*
+ * Cache
+ *
+ * A header line, then one line per file:
+ *   # keccakmanifest <algorithm> <start of the run, seconds>
+ *   <hex digest> <size> <mtime seconds>.<mtime nanoseconds> <path>
+ */
+typedef struct {
+    ManifestFile * files;       // Sorted by path
+    size_t nrFiles;
+    int64_t startSeconds;
+} ManifestCache;
+
+static int32_t ParseHex(const char * hex, uint8_t * data, uint32_t length)
+{
+    uint32_t i;
+
+    for(i = 0; i < 2 * length; i++) {
+        char c = hex[i];
+        uint8_t nibble;
+
+        if ((c >= '0') && (c <= '9')) {
+            nibble = (uint8_t) (c - '0');
+        }
+        else if ((c >= 'a') && (c <= 'f')) {
+            nibble = (uint8_t) (c - 'a' + 10);
+        }
+        else if ((c >= 'A') && (c <= 'F')) {
+            nibble = (uint8_t) (c - 'A' + 10);
+        }
+        else {
+            return -1;
+        }
+        data[i / 2] = (uint8_t) ((i % 2) ? (data[i / 2] | nibble) : (nibble << 4));
+    }
+    return 0;
+}
+
+static void FormatHex(const uint8_t * data, uint32_t length, char * hex)
+{
+    uint32_t i;
+
+    for(i = 0; i < length; i++) {
+        sprintf(hex + (2 * i), "%02x", data[i]);
+    }
+}
+
+static void StripNewline(char * line, ssize_t * length)
+{
+    while((*length > 0) && ((line[*length - 1] == '\n') || (line[*length - 1] == '\r'))) {
+        line[--*length] = 0;
+    }
+}
+
+static int32_t AppendFile(ManifestFile ** files, size_t * nrFiles, size_t * capacity, const ManifestFile * file)
+{
+    if (*nrFiles == *capacity) {
+        size_t newCapacity = (*capacity == 0) ? 1024 : 2 * *capacity;
+        ManifestFile * newFiles = realloc(*files, newCapacity * sizeof(ManifestFile));
+        if (newFiles == NULL) {
+            return ENOMEM;
+        }
+        *files = newFiles;
+        *capacity = newCapacity;
+    }
+    (*files)[(*nrFiles)++] = *file;
+    return 0;
+}
+
+/**
+  * Load the cache written by a run with the same algorithm. A missing cache,
+  * or one for another algorithm, is empty; malformed lines are skipped.
+  */
+static void LoadCache(const char * cachePath, ManifestAlgorithm algorithm, ManifestCache * cache)
+{
+    char * line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLength;
+    size_t capacity = 0;
+    char name[32];
+    long long startSeconds;
+    FILE * stream;
+
+    memset(cache, 0, sizeof(ManifestCache));
+
+    stream = fopen(cachePath, "r");
+    if (stream == NULL) {
+        return;
+    }
+
+    if ((getline(&line, &lineCapacity, stream) < 0) ||
+        (sscanf(line, "# keccakmanifest %31s %lld", name, &startSeconds) != 2) ||
+        (strcmp(name, AlgorithmNames[algorithm]) != 0)) {
+        free(line);
+        fclose(stream);
+        return;
+    }
+    cache->startSeconds = (int64_t) startSeconds;
+
+    while((lineLength = getline(&line, &lineCapacity, stream)) >= 0) {
+        ManifestFile file;
+        char * field;
+        char * end;
+
+        StripNewline(line, &lineLength);
+        memset(&file, 0, sizeof(file));
+
+        if ((lineLength < 2 * DigestByteLen + 1) || (line[2 * DigestByteLen] != ' ') ||
+            (ParseHex(line, file.digest, DigestByteLen) != 0)) {
+            continue;
+        }
+        field = line + 2 * DigestByteLen + 1;
+        file.size = strtoull(field, &end, 10);
+        if ((end == field) || (*end != ' ')) {
+            continue;
+        }
+        field = end + 1;
+        file.mtimeSeconds = strtoll(field, &end, 10);
+        if ((end == field) || (*end != '.')) {
+            continue;
+        }
+        field = end + 1;
+        file.mtimeNanoseconds = strtoll(field, &end, 10);
+        if ((end == field) || (*end != ' ') || (end[1] == 0)) {
+            continue;
+        }
+        file.path = strdup(end + 1);
+        if ((file.path == NULL) || (AppendFile(&cache->files, &cache->nrFiles, &capacity, &file) != 0)) {
+            free(file.path);
+            break;
+        }
+    }
+
+    free(line);
+    fclose(stream);
+
+    qsort(cache->files, cache->nrFiles, sizeof(ManifestFile), CompareFiles);
+}
+
+/**
+  * Take the digest of @a file from the cache if its size and modification time
+  * match and it was not modified around the run that wrote the cache.
+  */
+static int32_t LookUpCache(const ManifestCache * cache, ManifestFile * file)
+{
+    const ManifestFile * entry = bsearch(file, cache->files, cache->nrFiles, sizeof(ManifestFile), CompareFiles);
+
+    if ((entry == NULL) || (entry->size != file->size) ||
+        (entry->mtimeSeconds != file->mtimeSeconds) || (entry->mtimeNanoseconds != file->mtimeNanoseconds) ||
+        (file->mtimeSeconds >= cache->startSeconds - RacyMarginSeconds)) {
+        return 0;
+    }
+
+    memcpy(file->digest, entry->digest, DigestByteLen);
+    file->cached = 1;
+    return 1;
+}
+
+static void FreeFiles(ManifestFile * files, size_t nrFiles)
+{
+    size_t i;
+
+    for(i = 0; i < nrFiles; i++) {
+        free(files[i].path);
+    }
+    free(files);
+}
+
+/**
+  * Write the cache to a temporary file and rename it over @a cachePath.
+  * @return 0, or 1 after printing an error.
+  */
+static int32_t WriteCache(const char * cachePath, ManifestAlgorithm algorithm, int64_t startSeconds,
+                          const ManifestFile * files, size_t nrFiles)
+{
+    char hex[2 * DigestByteLen + 1];
+    size_t pathLength = strlen(cachePath);
+    char * temporaryPath = malloc(pathLength + 5);
+    FILE * stream;
+    size_t i;
+
+    if (temporaryPath == NULL) {
+        fprintf(stderr, "%s: %s: %s\n", programName, cachePath, strerror(ENOMEM));
+        return 1;
+    }
+    memcpy(temporaryPath, cachePath, pathLength);
+    memcpy(temporaryPath + pathLength, ".tmp", 5);
+
+    stream = fopen(temporaryPath, "w");
+    if (stream == NULL) {
+        fprintf(stderr, "%s: %s: %s\n", programName, temporaryPath, strerror(errno));
+        free(temporaryPath);
+        return 1;
+    }
+
+    fprintf(stream, "# keccakmanifest %s %lld\n", AlgorithmNames[algorithm], (long long) startSeconds);
+    for(i = 0; i < nrFiles; i++) {
+        if (files[i].error != 0) {
+            continue;
+        }
+        FormatHex(files[i].digest, DigestByteLen, hex);
+        fprintf(stream, "%s %llu %lld.%09lld %s\n", hex, (unsigned long long) files[i].size,
+                (long long) files[i].mtimeSeconds, (long long) files[i].mtimeNanoseconds, files[i].path);
+    }
+
+    if ((fclose(stream) != 0) || (rename(temporaryPath, cachePath) != 0)) {
+        fprintf(stderr, "%s: %s: %s\n", programName, cachePath, strerror(errno));
+        unlink(temporaryPath);
+        free(temporaryPath);
+        return 1;
+    }
+
+    free(temporaryPath);
+    return 0;
+}
+
+/**
+  * Load a manifest written by keccakmanifest or keccaksum, sorted by path.
+  * @return 0, or 1 after printing an error.
+  */
+static int32_t LoadManifest(const char * manifestPath, ManifestFile ** files, size_t * nrFiles, uint64_t * malformed)
+{
+    char * line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLength;
+    size_t capacity = 0;
+    FILE * stream;
+
+    *files = NULL;
+    *nrFiles = 0;
+    *malformed = 0;
+
+    if (strcmp(manifestPath, "-") == 0) {
+        stream = stdin;
+    }
+    else {
+        stream = fopen(manifestPath, "r");
+        if (stream == NULL) {
+            fprintf(stderr, "%s: %s: %s\n", programName, manifestPath, strerror(errno));
+            return 1;
+        }
+    }
+
+    while((lineLength = getline(&line, &lineCapacity, stream)) >= 0) {
+        ManifestFile file;
+
+        StripNewline(line, &lineLength);
+        memset(&file, 0, sizeof(file));
+
+        // "<hex>  <name>" or "<hex> *<name>", as for keccaksum --check
+        if ((lineLength < 2 * DigestByteLen + 3) || (line[2 * DigestByteLen] != ' ') ||
+            ((line[2 * DigestByteLen + 1] != ' ') && (line[2 * DigestByteLen + 1] != '*')) ||
+            (ParseHex(line, file.digest, DigestByteLen) != 0)) {
+            (*malformed)++;
+            continue;
+        }
+
+        file.path = strdup(line + 2 * DigestByteLen + 2);
+        if ((file.path == NULL) || (AppendFile(files, nrFiles, &capacity, &file) != 0)) {
+            free(file.path);
+            fprintf(stderr, "%s: %s: %s\n", programName, manifestPath, strerror(ENOMEM));
+            free(line);
+            if (stream != stdin) {
+                fclose(stream);
+            }
+            return 1;
+        }
+    }
+
+    free(line);
+    if (stream != stdin) {
+        fclose(stream);
+    }
+
+    qsort(*files, *nrFiles, sizeof(ManifestFile), CompareFiles);
+    return 0;
+}
+
+/**
+  * Compare the hashed tree with a manifest and print every file that differs.
+  * @return 0 if they match, 1 otherwise.
+  */
+static int32_t CheckManifest(const char * manifestPath, const ManifestFile * files, size_t nrFiles)
+{
+    ManifestFile * expected;
+    size_t nrExpected;
+    uint64_t malformed;
+    uint64_t mismatches = 0;
+    uint64_t unreadable = 0;
+    uint64_t missing = 0;
+    uint64_t added = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    if (LoadManifest(manifestPath, &expected, &nrExpected, &malformed) != 0) {
+        return 1;
+    }
+
+    // Both lists are sorted by path
+    while((i < nrFiles) || (j < nrExpected)) {
+        int order = (i == nrFiles) ? 1 : (j == nrExpected) ? -1 : strcmp(files[i].path, expected[j].path);
+
+        if (order < 0) {
+            printf("%s: NEW\n", files[i++].path);
+            added++;
+        }
+        else if (order > 0) {
+            printf("%s: MISSING\n", expected[j++].path);
+            missing++;
+        }
+        else {
+            if (files[i].error != 0) {
+                printf("%s: FAILED open or read\n", files[i].path);
+                unreadable++;
+            }
+            else if (memcmp(files[i].digest, expected[j].digest, DigestByteLen) != 0) {
+                printf("%s: FAILED\n", files[i].path);
+                mismatches++;
+            }
+            i++;
+            j++;
+        }
+    }
+
+    if (malformed > 0) {
+        fprintf(stderr, "%s: WARNING: %llu lines are improperly formatted\n", programName, (unsigned long long) malformed);
+    }
+    if (unreadable > 0) {
+        fprintf(stderr, "%s: WARNING: %llu listed files could not be read\n", programName, (unsigned long long) unreadable);
+    }
+    if (mismatches > 0) {
+        fprintf(stderr, "%s: WARNING: %llu computed checksums did NOT match\n", programName, (unsigned long long) mismatches);
+    }
+    if (missing > 0) {
+        fprintf(stderr, "%s: WARNING: %llu listed files are missing\n", programName, (unsigned long long) missing);
+    }
+    if (added > 0) {
+        fprintf(stderr, "%s: WARNING: %llu files are not listed\n", programName, (unsigned long long) added);
+    }
+
+    FreeFiles(expected, nrExpected);
+    return ((malformed > 0) || (unreadable > 0) || (mismatches > 0) || (missing > 0) || (added > 0)) ? 1 : 0;
+}
+
+static void PrintUsage(FILE * stream)
+{
+    uint32_t i;
+
+    fprintf(stream, "Usage: %s [OPTION]... [DIRECTORY]\n", programName);
+    fprintf(stream, "Print the manifest of the regular files under DIRECTORY, the current directory by default,\n");
+    fprintf(stream, "or check the tree against a manifest.\n\n");
+    fprintf(stream, "  -a, --algorithm NAME   digest of each file, sha3-256 by default:\n                        ");
+    for(i = 0; i < nrAlgorithms; i++) {
+        fprintf(stream, " %s", AlgorithmNames[i]);
+    }
+    fprintf(stream, "\n");
+    fprintf(stream, "  -j, --threads N        number of hashing threads, one per online CPU by default\n");
+    fprintf(stream, "      --split-size BYTES parallelhash256 files from this size are spread over all the threads\n");
+    fprintf(stream, "  -C, --cache FILE       reuse and update the digests of files whose size and mtime did not change\n");
+    fprintf(stream, "  -c, --check MANIFEST   print the files that differ from MANIFEST instead of a manifest\n");
+    fprintf(stream, "  -v, --verbose          print statistics to standard error\n");
+    fprintf(stream, "  -h, --help             print this help\n");
+}
+
+static int32_t ParseSize(const char * text, uint64_t * value)
+{
+    char * end;
+
+    errno = 0;
+    *value = strtoull(text, &end, 10);
+    return ((end == text) || (*end != 0) || (errno != 0) || (text[0] == '-')) ? -1 : 0;
+}
+
+int main(int argc, char * argv[])
+{
+    ManifestAlgorithm algorithm = ManifestSHA3_256;
+    const char * root = ".";
+    const char * cachePath = NULL;
+    const char * checkPath = NULL;
+    uint64_t splitByteLen = DefaultSplitByteLen;
+    uint64_t nrThreads = 0;
+    int32_t verbose = 0;
+    int32_t nrRoots = 0;
+    int32_t status = 0;
+    int32_t unreadableDirectories;
+    struct timespec start;
+    Manifest manifest;
+    ManifestCache cache;
+    int i;
+
+    for(i = 1; i < argc; i++) {
+        const char * argument = argv[i];
+        const char * value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if ((argument[0] != '-') || (argument[1] == 0)) {
+            root = argument;
+            nrRoots++;
+            continue;
+        }
+        if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "--help") == 0)) {
+            PrintUsage(stdout);
+            return 0;
+        }
+        if ((strcmp(argument, "-v") == 0) || (strcmp(argument, "--verbose") == 0)) {
+            verbose = 1;
+            continue;
+        }
+
+        // Every other option takes a value
+        if (value == NULL) {
+            PrintUsage(stderr);
+            return 1;
+        }
+        i++;
+
+        if ((strcmp(argument, "-a") == 0) || (strcmp(argument, "--algorithm") == 0)) {
+            uint32_t a;
+            for(a = 0; a < nrAlgorithms; a++) {
+                if (strcasecmp(value, AlgorithmNames[a]) == 0) {
+                    break;
+                }
+            }
+            if (a == nrAlgorithms) {
+                fprintf(stderr, "%s: unknown algorithm '%s'\n", programName, value);
+                return 1;
+            }
+            algorithm = (ManifestAlgorithm) a;
+        }
+        else if ((strcmp(argument, "-j") == 0) || (strcmp(argument, "--threads") == 0)) {
+            if ((ParseSize(value, &nrThreads) != 0) || (nrThreads == 0) || (nrThreads > MaximumThreads)) {
+                fprintf(stderr, "%s: invalid number of threads '%s'\n", programName, value);
+                return 1;
+            }
+        }
+        else if (strcmp(argument, "--split-size") == 0) {
+            if (ParseSize(value, &splitByteLen) != 0) {
+                fprintf(stderr, "%s: invalid size '%s'\n", programName, value);
+                return 1;
+            }
+        }
+        else if ((strcmp(argument, "-C") == 0) || (strcmp(argument, "--cache") == 0)) {
+            cachePath = value;
+        }
+        else if ((strcmp(argument, "-c") == 0) || (strcmp(argument, "--check") == 0)) {
+            checkPath = value;
+        }
+        else {
+            fprintf(stderr, "%s: unknown option '%s'\n", programName, argument);
+            PrintUsage(stderr);
+            return 1;
+        }
+    }
+
+    if (nrRoots > 1) {
+        fprintf(stderr, "%s: only one directory may be given\n", programName);
+        return 1;
+    }
+
+    if (nrThreads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        nrThreads = (online < 1) ? 1 : (online > MaximumThreads) ? MaximumThreads : (uint64_t) online;
+    }
+
+    memset(&manifest, 0, sizeof(manifest));
+    manifest.algorithm = algorithm;
+    manifest.nrWorkers = (uint32_t) nrThreads;
+
+    manifest.rootFd = open(root, O_RDONLY | O_DIRECTORY);
+    if (manifest.rootFd < 0) {
+        fprintf(stderr, "%s: %s: %s\n", programName, root, strerror(errno));
+        return 1;
+    }
+
+    // Files modified from here on may be hashed before or after the change
+    clock_gettime(CLOCK_REALTIME, &start);
+
+    if (WalkTree(root, &manifest.files, &manifest.nrFiles, &unreadableDirectories) != 0) {
+        close(manifest.rootFd);
+        return 1;
+    }
+    status |= unreadableDirectories;
+
+    // Decide which files to hash: not cached, and in which phase
+    int32_t * pending = calloc(manifest.nrFiles + 1, sizeof(int32_t));
+    size_t * split = malloc((manifest.nrFiles + 1) * sizeof(size_t));
+    size_t nrSplit = 0;
+    size_t nrCached = 0;
+
+    manifest.deques = calloc(manifest.nrWorkers, sizeof(TaskDeque));
+    manifest.workers = calloc(manifest.nrWorkers, sizeof(ManifestWorker));
+    if ((pending == NULL) || (split == NULL) || (manifest.deques == NULL) || (manifest.workers == NULL)) {
+        fprintf(stderr, "%s: %s\n", programName, strerror(ENOMEM));
+        return 1;
+    }
+
+    if (cachePath != NULL) {
+        LoadCache(cachePath, algorithm, &cache);
+    }
+    else {
+        memset(&cache, 0, sizeof(cache));
+    }
+
+    size_t f;
+    for(f = 0; f < manifest.nrFiles; f++) {
+        ManifestFile * file = &manifest.files[f];
+
+        if (LookUpCache(&cache, file)) {
+            nrCached++;
+        }
+        else if ((algorithm == ManifestParallelHash256) && (file->size >= splitByteLen) && (file->size > SmallFileByteLen)) {
+            split[nrSplit++] = f;
+        }
+        else {
+            pending[f] = 1;
+        }
+    }
+    FreeFiles(cache.files, cache.nrFiles);
+
+    uint32_t w;
+    for(w = 0; w < manifest.nrWorkers; w++) {
+        pthread_mutex_init(&manifest.deques[w].lock, NULL);
+        manifest.workers[w].manifest = &manifest;
+        manifest.workers[w].index = w;
+        manifest.workers[w].buffer = malloc(BatchByteLen);
+        if (manifest.workers[w].buffer == NULL) {
+            fprintf(stderr, "%s: %s\n", programName, strerror(ENOMEM));
+            return 1;
+        }
+    }
+
+    int32_t error = HashFiles(&manifest, pending);
+    if (error != 0) {
+        fprintf(stderr, "%s: %s\n", programName, strerror(error));
+        return 1;
+    }
+
+    // Then the large ParallelHash256 files, one at a time on all the threads
+    if (nrSplit > 0) {
+        KeccakThreadPool * pool = (manifest.nrWorkers > 1) ? KeccakThreadPoolCreate(manifest.nrWorkers) : NULL;
+
+        for(f = 0; f < nrSplit; f++) {
+            HashLargeFile(&manifest, &manifest.workers[0], &manifest.files[split[f]], pool);
+        }
+        KeccakThreadPoolDestroy(pool);
+    }
+
+    if (checkPath != NULL) {
+        status |= CheckManifest(checkPath, manifest.files, manifest.nrFiles);
+    }
+    else {
+        char hex[2 * DigestByteLen + 1];
+
+        for(f = 0; f < manifest.nrFiles; f++) {
+            if (manifest.files[f].error == 0) {
+                FormatHex(manifest.files[f].digest, DigestByteLen, hex);
+                printf("%s  %s\n", hex, manifest.files[f].path);
+            }
+        }
+    }
+
+    for(f = 0; f < manifest.nrFiles; f++) {
+        if (manifest.files[f].error != 0) {
+            fprintf(stderr, "%s: %s: %s\n", programName, manifest.files[f].path, strerror(manifest.files[f].error));
+            status = 1;
+        }
+    }
+
+    if (cachePath != NULL) {
+        status |= WriteCache(cachePath, algorithm, (int64_t) start.tv_sec, manifest.files, manifest.nrFiles);
+    }
+
+    if (verbose) {
+        uint64_t filesHashed = 0;
+        uint64_t bytesHashed = 0;
+        uint64_t steals = 0;
+
+        for(w = 0; w < manifest.nrWorkers; w++) {
+            filesHashed += manifest.workers[w].filesHashed;
+            bytesHashed += manifest.workers[w].bytesHashed;
+            steals += manifest.workers[w].steals;
+        }
+        fprintf(stderr, "%s: %llu files, %llu hashed (%llu bytes), %llu from the cache, %llu split, "
+                "%llu tasks on %u threads, %llu steals\n",
+                programName, (unsigned long long) manifest.nrFiles, (unsigned long long) filesHashed,
+                (unsigned long long) bytesHashed, (unsigned long long) nrCached, (unsigned long long) nrSplit,
+                (unsigned long long) manifest.nrTasks, manifest.nrWorkers, (unsigned long long) steals);
+    }
+
+    for(w = 0; w < manifest.nrWorkers; w++) {
+        pthread_mutex_destroy(&manifest.deques[w].lock);
+        free(manifest.workers[w].buffer);
+    }
+    free(manifest.workers);
+    free(manifest.deques);
+    free(manifest.order);
+    free(manifest.tasks);
+    free(manifest.taskOrder);
+    free(pending);
+    free(split);
+    FreeFiles(manifest.files, manifest.nrFiles);
+    close(manifest.rootFd);
+
+    return status;
+}
@@ -0,0 +1,520 @@
+/*
+ * Copyright 2016 Nathaniel Graff
+ */
+
+/*
+ * keccaksum: print or check SHA3, Keccak and SHAKE checksums
+ *
+ * The output has the same format as sha256sum and friends:
+ *   <hex digest>  <file name>
+ * so a list written by keccaksum can be verified with keccaksum --check.
+ *
+ * Regular files are mapped into memory and absorbed in place. Pipes, terminals
+ * and files that cannot be mapped are read by a second thread into two large
+ * buffers in turn, so reading the next buffer overlaps with absorbing the last.
+ *
+ * A mapped file truncated by another process while it is absorbed raises
+ * SIGBUS. The handler jumps back out of the absorb, and the file is reported
+ * as an input/output error like a failed read, so the other files are hashed.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "KeccakSponge.h"
+
+// Size of each of the two buffers used for pipes
+#define ReadBufferSize (1 << 20)
+
+// Longest digest accepted, in bits
+#define MaximumOutputBitLen 8192
+
+typedef struct {
+    const char * name;
+    uint32_t capacity;
+    uint8_t delimitedSuffix;
+    uint32_t outputBitLen;      // Default output length
+    int32_t extendable;         // 1 if --length may change the output length
+} Algorithm;
+
+static const Algorithm Algorithms[] = {
+    {"sha3-224",   448,  SHA3DelimitedSuffix,   224, 0},
+    {"sha3-256",   512,  SHA3DelimitedSuffix,   256, 0},
+    {"sha3-384",   768,  SHA3DelimitedSuffix,   384, 0},
+    {"sha3-512",   1024, SHA3DelimitedSuffix,   512, 0},
+    {"keccak-224", 448,  KeccakDelimitedSuffix, 224, 0},
+    {"keccak-256", 512,  KeccakDelimitedSuffix, 256, 0},
+    {"keccak-384", 768,  KeccakDelimitedSuffix, 384, 0},
+    {"keccak-512", 1024, KeccakDelimitedSuffix, 512, 0},
+    {"shake128",   256,  SHAKEDelimitedSuffix,  256, 1},
+    {"shake256",   512,  SHAKEDelimitedSuffix,  512, 1},
+};
+
+#define nrAlgorithms (sizeof(Algorithms) / sizeof(Algorithms[0]))
+
+static const char * programName = "keccaksum";
+
+/*
+ * Double-buffered reads
+ *
+ * The reader thread fills buffer 0, 1, 0, 1, ... and the hashing thread
+ * absorbs them in the same order. A buffer is handed over by setting full[i],
+ * and handed back by clearing it. A buffer shorter than ReadBufferSize, possibly
+ * empty, is the last one, either at the end of the input or after a read error.
+ */
+typedef struct {
+    int fd;
+
+    uint8_t * buffers[2];
+    size_t lengths[2];
+    int32_t full[2];
+
+    int32_t readError;          // errno of the failed read, 0 if none
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} ReadPipeline;
+
+static void * ReaderMain(void * argument)
+{
+    ReadPipeline * pipeline = argument;
+    uint32_t current = 0;
+    size_t length;
+
+    do {
+        pthread_mutex_lock(&pipeline->lock);
+        while(pipeline->full[current]) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        pthread_mutex_unlock(&pipeline->lock);
+
+        // Fill the whole buffer so that each Absorb call gets many blocks
+        int32_t readError = 0;
+        length = 0;
+        while(length < ReadBufferSize) {
+            ssize_t bytesRead = read(pipeline->fd, pipeline->buffers[current] + length, ReadBufferSize - length);
+            if (bytesRead > 0) {
+                length += (size_t) bytesRead;
+            }
+            else if ((bytesRead < 0) && (errno == EINTR)) {
+                continue;
+            }
+            else {
+                if (bytesRead < 0) {
+                    readError = errno;
+                    length = 0;
+                }
+                break;
+            }
+        }
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->lengths[current] = length;
+        pipeline->full[current] = 1;
+        if (readError != 0) {
+            pipeline->readError = readError;
+        }
+        pthread_cond_signal(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->lock);
+
+        current ^= 1;
+    } while(length == ReadBufferSize); // A short buffer is the last one
+
+    return NULL;
+}
+
+/**
+  * Absorb everything read from @a fd, reading ahead on another thread.
+  * @return 0, or the errno of the failed read or allocation.
+  */
+static int32_t AbsorbPipe(SpongeState * state, int fd)
+{
+    ReadPipeline pipeline;
+    pthread_t reader;
+    uint32_t current = 0;
+
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.fd = fd;
+    pipeline.buffers[0] = malloc(ReadBufferSize);
+    pipeline.buffers[1] = malloc(ReadBufferSize);
+
+    if ((pipeline.buffers[0] == NULL) || (pipeline.buffers[1] == NULL)) {
+        free(pipeline.buffers[0]);
+        free(pipeline.buffers[1]);
+        return ENOMEM;
+    }
+
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.changed, NULL);
+
+    if (pthread_create(&reader, NULL, ReaderMain, &pipeline) != 0) {
+        pthread_cond_destroy(&pipeline.changed);
+        pthread_mutex_destroy(&pipeline.lock);
+        free(pipeline.buffers[0]);
+        free(pipeline.buffers[1]);
+        return EAGAIN;
+    }
+
+    while(1) {
+        pthread_mutex_lock(&pipeline.lock);
+        while(!pipeline.full[current]) {
+            pthread_cond_wait(&pipeline.changed, &pipeline.lock);
+        }
+        size_t length = pipeline.lengths[current];
+        pthread_mutex_unlock(&pipeline.lock);
+
+        if (length == 0) {
+            break;
+        }
+
+        AbsorbBytes(state, pipeline.buffers[current], length);
+
+        pthread_mutex_lock(&pipeline.lock);
+        pipeline.full[current] = 0;
+        pthread_cond_signal(&pipeline.changed);
+        pthread_mutex_unlock(&pipeline.lock);
+
+        if (length < ReadBufferSize) {
+            break;
+        }
+        current ^= 1;
+    }
+
+    pthread_join(reader, NULL);
+
+    pthread_cond_destroy(&pipeline.changed);
+    pthread_mutex_destroy(&pipeline.lock);
+    free(pipeline.buffers[0]);
+    free(pipeline.buffers[1]);
+
+    return pipeline.readError;
+}
+
+/*
+ * Truncated mappings
+ *
+ * Only the main thread absorbs mappings, so one jump buffer is enough. The
+ * handler is installed for the duration of one absorb.
+ */
+static sigjmp_buf mappingFault;
+
+static void MappingFaultHandler(int signalNumber)
+{
+    (void) signalNumber;
+    siglongjmp(mappingFault, 1);
+}
+
+/**
+  * Absorb a regular file through a read-only mapping.
+  * @return 0, -1 if the file cannot be mapped and must be read instead,
+  *         or EIO if the file was truncated while it was absorbed.
+  */
+static int32_t AbsorbMapped(SpongeState * state, int fd, off_t size)
+{
+    struct sigaction faultAction;
+    struct sigaction previousAction;
+    int32_t error = 0;
+
+    if (size == 0) {
+        return 0;
+    }
+    if ((uint64_t) size > SIZE_MAX) {
+        return -1;
+    }
+
+    void * mapping = mmap(NULL, (size_t) size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return -1;
+    }
+
+    posix_madvise(mapping, (size_t) size, POSIX_MADV_SEQUENTIAL);
+
+    memset(&faultAction, 0, sizeof(faultAction));
+    faultAction.sa_handler = MappingFaultHandler;
+    sigemptyset(&faultAction.sa_mask);
+    sigaction(SIGBUS, &faultAction, &previousAction);
+
+    if (sigsetjmp(mappingFault, 1) == 0) {
+        AbsorbBytes(state, mapping, size);
+    }
+    else {
+        error = EIO;
+    }
+
+    sigaction(SIGBUS, &previousAction, NULL);
+
+    munmap(mapping, (size_t) size);
+    return error;
+}
+
+/**
+  * Hash one file, or standard input for "-".
+  * @return 0, or -1 after printing an error.
+  */
+static int32_t HashFile(const Algorithm * algorithm, uint32_t outputBitLen, const char * path, uint8_t * digest)
+{
+    SpongeState state;
+    struct stat status;
+    int32_t error = 0;
+    int fd;
+
+    if (strcmp(path, "-") == 0) {
+        fd = STDIN_FILENO;
+    }
+    else {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "%s: %s: %s\n", programName, path, strerror(errno));
+            return -1;
+        }
+    }
+
+    InitSponge(&state, 1600 - algorithm->capacity, algorithm->capacity);
+    state.delimitedSuffix = algorithm->delimitedSuffix;
+
+    error = -1;
+    if ((fstat(fd, &status) == 0) && S_ISREG(status.st_mode)) {
+        error = AbsorbMapped(&state, fd, status.st_size);
+    }
+    if (error < 0) {
+        error = AbsorbPipe(&state, fd);
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    if (error != 0) {
+        fprintf(stderr, "%s: %s: %s\n", programName, path, strerror(error));
+        EraseState(&state);
+        return -1;
+    }
+
+    Squeeze(&state, digest, outputBitLen);
+    EraseState(&state);
+
+    return 0;
+}
+
+static void PrintHex(const uint8_t * data, uint32_t length)
+{
+    uint32_t i;
+    for(i = 0; i < length; i++) {
+        printf("%02x", data[i]);
+    }
+}
+
+/**
+  * Verify every "<hex digest>  <file name>" line of a checksum list.
+  * @return 0 if every listed file matches, 1 otherwise.
+  */
+static int32_t CheckList(const Algorithm * algorithm, uint32_t outputBitLen, const char * listPath)
+{
+    static uint8_t digest[MaximumOutputBitLen / 8];
+    char hex[2 * (MaximumOutputBitLen / 8) + 1];
+    uint64_t mismatches = 0;
+    uint64_t unreadable = 0;
+    uint64_t malformed = 0;
+    uint64_t lineNumber = 0;
+    char * line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLength;
+    FILE * list;
+
+    if (strcmp(listPath, "-") == 0) {
+        list = stdin;
+    }
+    else {
+        list = fopen(listPath, "r");
+        if (list == NULL) {
+            fprintf(stderr, "%s: %s: %s\n", programName, listPath, strerror(errno));
+            return 1;
+        }
+    }
+
+    while((lineLength = getline(&line, &lineCapacity, list)) >= 0) {
+        lineNumber++;
+
+        while((lineLength > 0) && ((line[lineLength - 1] == '\n') || (line[lineLength - 1] == '\r'))) {
+            line[--lineLength] = 0;
+        }
+
+        // "<hex>  <name>" for text mode or "<hex> *<name>" for binary mode, which hash the same
+        size_t hexLength = strspn(line, "0123456789abcdefABCDEF");
+        uint32_t lineOutputBitLen = (uint32_t) hexLength * 4;
+
+        if ((hexLength == 0) || ((hexLength % 2) != 0) || (hexLength > 2 * (MaximumOutputBitLen / 8)) ||
+            (line[hexLength] != ' ') || ((line[hexLength + 1] != ' ') && (line[hexLength + 1] != '*')) ||
+            (line[hexLength + 2] == 0) ||
+            (!algorithm->extendable && (lineOutputBitLen != outputBitLen))) {
+            malformed++;
+            continue;
+        }
+
+        const char * path = line + hexLength + 2;
+
+        if (HashFile(algorithm, lineOutputBitLen, path, digest) != 0) {
+            printf("%s: FAILED open or read\n", path);
+            unreadable++;
+            continue;
+        }
+
+        uint32_t i;
+        for(i = 0; i < lineOutputBitLen / 8; i++) {
+            sprintf(hex + (2 * i), "%02x", digest[i]);
+        }
+
+        if (strncasecmp(hex, line, hexLength) == 0) {
+            printf("%s: OK\n", path);
+        }
+        else {
+            printf("%s: FAILED\n", path);
+            mismatches++;
+        }
+    }
+
+    free(line);
+    if (list != stdin) {
+        fclose(list);
+    }
+
+    if (malformed > 0) {
+        fprintf(stderr, "%s: WARNING: %llu of %llu lines are improperly formatted\n",
+                programName, (unsigned long long) malformed, (unsigned long long) lineNumber);
+    }
+    if (unreadable > 0) {
+        fprintf(stderr, "%s: WARNING: %llu listed files could not be read\n",
+                programName, (unsigned long long) unreadable);
+    }
+    if (mismatches > 0) {
+        fprintf(stderr, "%s: WARNING: %llu computed checksums did NOT match\n",
+                programName, (unsigned long long) mismatches);
+    }
+
+    return ((mismatches > 0) || (unreadable > 0) || (malformed == lineNumber)) ? 1 : 0;
+}
+
+static void PrintUsage(FILE * stream)
+{
+    uint32_t i;
+
+    fprintf(stream, "Usage: %s [OPTION]... [FILE]...\n", programName);
+    fprintf(stream, "Print or check checksums. With no FILE, or when FILE is -, read standard input.\n\n");
+    fprintf(stream, "  -a, --algorithm NAME  hash function, sha3-256 by default:\n                       ");
+    for(i = 0; i < nrAlgorithms; i++) {
+        fprintf(stream, " %s", Algorithms[i].name);
+    }
+    fprintf(stream, "\n");
+    fprintf(stream, "  -l, --length BITS     output length for shake128 and shake256, a multiple of 8\n");
+    fprintf(stream, "  -c, --check           read checksums from the FILEs and check them\n");
+    fprintf(stream, "  -h, --help            print this help\n");
+}
+
+int main(int argc, char * argv[])
+{
+    static uint8_t digest[MaximumOutputBitLen / 8];
+    const Algorithm * algorithm = &Algorithms[1];
+    uint32_t outputBitLen = 0;
+    int32_t check = 0;
+    int32_t status = 0;
+    int32_t optionsDone = 0;
+    int32_t nrFiles = 0;
+    int i;
+
+    // Collect the options first; every other argument is a file, "--" ends the options
+    for(i = 1; i < argc; i++) {
+        const char * argument = argv[i];
+
+        if (optionsDone || (argument[0] != '-') || (argument[1] == 0)) {
+            argv[1 + nrFiles++] = argv[i];
+        }
+        else if (strcmp(argument, "--") == 0) {
+            optionsDone = 1;
+        }
+        else if ((strcmp(argument, "-a") == 0) || (strcmp(argument, "--algorithm") == 0)) {
+            if (++i == argc) {
+                PrintUsage(stderr);
+                return 1;
+            }
+
+            uint32_t a;
+            algorithm = NULL;
+            for(a = 0; a < nrAlgorithms; a++) {
+                if (strcasecmp(argv[i], Algorithms[a].name) == 0) {
+                    algorithm = &Algorithms[a];
+                }
+            }
+            if (algorithm == NULL) {
+                fprintf(stderr, "%s: unknown algorithm '%s'\n", programName, argv[i]);
+                return 1;
+            }
+        }
+        else if ((strcmp(argument, "-l") == 0) || (strcmp(argument, "--length") == 0)) {
+            if (++i == argc) {
+                PrintUsage(stderr);
+                return 1;
+            }
+
+            char * end;
+            unsigned long length = strtoul(argv[i], &end, 10);
+            if ((*end != 0) || (length == 0) || ((length % 8) != 0) || (length > MaximumOutputBitLen)) {
+                fprintf(stderr, "%s: invalid length '%s'\n", programName, argv[i]);
+                return 1;
+            }
+            outputBitLen = (uint32_t) length;
+        }
+        else if ((strcmp(argument, "-c") == 0) || (strcmp(argument, "--check") == 0)) {
+            check = 1;
+        }
+        else if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "--help") == 0)) {
+            PrintUsage(stdout);
+            return 0;
+        }
+        else {
+            fprintf(stderr, "%s: unknown option '%s'\n", programName, argument);
+            PrintUsage(stderr);
+            return 1;
+        }
+    }
+
+    if (outputBitLen == 0) {
+        outputBitLen = algorithm->outputBitLen;
+    }
+    else if (!algorithm->extendable) {
+        fprintf(stderr, "%s: --length only applies to shake128 and shake256\n", programName);
+        return 1;
+    }
+
+    if (nrFiles == 0) {
+        argv[1] = "-";
+        nrFiles = 1;
+    }
+
+    for(i = 1; i <= nrFiles; i++) {
+        if (check) {
+            status |= CheckList(algorithm, outputBitLen, argv[i]);
+        }
+        else if (HashFile(algorithm, outputBitLen, argv[i], digest) == 0) {
+            PrintHex(digest, outputBitLen / 8);
+            printf("  %s\n", argv[i]);
+        }
+        else {
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -7,6 +7,19 @@
 #include <string.h>
 
 #include "KeccakNISTInterface.h"
+#include "KeccakF-1600-reference.h"
+#include "KeccakF-1600-opt64.h"
+#include "KeccakF-1600-times.h"
+#include "KeccakF-1600-dispatch.h"
+#include "KeccakTreeHash.h"
+#include "KeccakFIPS202.h"
+#include "KeccakSpongeArena.h"
+#include "KeccakMerkleTree.h"
+#include "KeccakSP800185.h"
+#include "KeccakDRBG.h"
+#include "KeccakSpongeWrap.h"
+#include "KeccakInstrumentation.h"
+#include "KeccakErase.h"
 
 #define RESET_COLOR   "\033[0m"
 #define RED_COLOR     "\033[31m"
@@ -23,7 +36,7 @@ void KeccakN(uint32_t N, BitSequence * data, DataLength dataBitLen, char * outpu
     for(i = 0; i < (N/8); i++)
     {
         sprintf(temp, "%02x", output[i]);
-        strncpy((outputBuf+(2*i)), temp, 2);
+        memcpy((outputBuf+(2*i)), temp, 2);
     }
     outputBuf[2*N/8] = 0;
 
@@ -51,10 +64,1174 @@ uint32_t TestKeccakN(uint32_t N, char * inputData, uint32_t inputDataLen, char *
     }
 }
 
+void ToHex(const BitSequence * data, uint32_t dataLength, char * outputBuf)
+{
+    uint32_t i;
+    for(i = 0; i < dataLength; i++) {
+        sprintf(outputBuf + (2*i), "%02x", data[i]);
+    }
+    outputBuf[2*dataLength] = 0;
+}
+
+void FillPattern(BitSequence * data, uint32_t dataLength)
+{
+    uint32_t i;
+    for(i = 0; i < dataLength; i++) {
+        data[i] = i % 251;
+    }
+}
+
+uint32_t CheckOutput(char * outputBuf, char * expectedOutput)
+{
+    printf("Expected: %s\n", expectedOutput);
+
+    if(strcmp(outputBuf, expectedOutput) == 0) {
+        printf(GREEN_COLOR "Output:   %s\n" RESET_COLOR, outputBuf);
+        printf("Test passed\n\n");
+        return 0;
+    } else {
+        printf(RED_COLOR "Output:   %s\n" RESET_COLOR, outputBuf);
+        printf("Test failed\n\n");
+        return 1;
+    }
+}
+
+uint32_t TestKeccakStreaming(uint32_t N, uint32_t inputDataLen, char * expectedOutput)
+{
+    printf("Running Keccak%d on %d-byte pattern fed in uneven pieces\n", N, inputDataLen);
+
+    // Piece sizes chosen to leave partial blocks open and to cross block boundaries
+    static const uint32_t pieces[] = {1, 7, 100, 13, 300};
+
+    BitSequence * input = malloc(inputDataLen);
+    BitSequence output[64];
+    char outputBuf[129];
+    HashState state;
+
+    FillPattern(input, inputDataLen);
+
+    Init(&state, N);
+
+    uint32_t offset = 0;
+    uint32_t piece = 0;
+    while(offset < inputDataLen) {
+        uint32_t length = pieces[piece % 5];
+        if(length > inputDataLen - offset) {
+            length = inputDataLen - offset;
+        }
+        Update(&state, input + offset, (DataLength) length * 8);
+        offset += length;
+        piece++;
+    }
+
+    Final(&state, output);
+    EraseState(&state);
+
+    ToHex(output, N/8, outputBuf);
+    free(input);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestKeccakSqueeze(uint32_t outputLength, char * expectedOutput)
+{
+    printf("Running Keccak[] on 1000-byte pattern with %d bytes of output squeezed in pieces\n", outputLength);
+
+    BitSequence input[1000];
+    BitSequence * output = malloc(outputLength);
+    char * outputBuf = malloc(2*outputLength + 1);
+    HashState state;
+
+    FillPattern(input, sizeof(input));
+
+    Init(&state, 0);
+    Update(&state, input, sizeof(input) * 8);
+
+    // Squeeze in pieces that straddle the 128-byte output blocks
+    uint32_t offset = 0;
+    uint32_t length = 1;
+    while(offset < outputLength) {
+        if(length > outputLength - offset) {
+            length = outputLength - offset;
+        }
+        Squeeze(&state, output + offset, (uint64_t) length * 8);
+        offset += length;
+        length = (length * 3) + 5;
+    }
+    EraseState(&state);
+
+    ToHex(output, outputLength, outputBuf);
+
+    uint32_t result = CheckOutput(outputBuf, expectedOutput);
+
+    free(outputBuf);
+    free(output);
+
+    return result;
+}
+
+uint32_t TestKeccakTimesN(uint32_t N, uint32_t rounds)
+{
+    printf("Checking %d-state permutation and absorb with %d rounds against single states\n", N, rounds);
+
+    SpongeMatrix states[KeccakMaxParallelism];
+    SpongeMatrix expected[KeccakMaxParallelism];
+    BitSequence input[KeccakMaxParallelism * 168];
+    const uint8_t * data[KeccakMaxParallelism];
+    uint32_t s, i;
+
+    FillPattern(input, sizeof(input));
+
+    // Give every state a different starting value
+    for(s = 0; s < N; s++) {
+        for(i = 0; i < nrLanes; i++) {
+            SpongeLane(states[s], i) = (s + 1) * (i + 1) * 0x9E3779B97F4A7C15ULL;
+        }
+        memcpy(expected[s], states[s], sizeof(SpongeMatrix));
+        data[s] = input + (s * 168);
+    }
+
+    if(N == 4) {
+        KeccakPermutationRoundsTimes4(states, rounds);
+        KeccakAbsorbRoundsTimes4(states, data, 1344, rounds);
+    } else {
+        KeccakPermutationRoundsTimes8(states, rounds);
+        KeccakAbsorbRoundsTimes8(states, data, 1344, rounds);
+    }
+
+    for(s = 0; s < N; s++) {
+        KeccakPermutationRoundsReference(expected[s], rounds);
+        KeccakXorDataIntoState(expected[s], data[s], 168);
+        KeccakPermutationRoundsReference(expected[s], rounds);
+
+        if(memcmp(states[s], expected[s], sizeof(SpongeMatrix)) != 0) {
+            printf(RED_COLOR "State %d differs from the single-state permutation\n" RESET_COLOR, s);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    printf("Test passed\n\n");
+    return 0;
+}
+
+uint32_t TestHashBatch(uint32_t N)
+{
+    printf("Running HashBatch and HashBatchFixed for Keccak%d against Hash\n", N);
+
+    // Lengths in bits around the block boundaries of all four rates, plus a partial byte
+    static const DataLength lengths[] = {0, 8, 13, 248, 568, 576, 584, 1080, 1088, 1096, 4000, 8000};
+    const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+
+    BitSequence input[1000 + 16]; // Room for the 1000-byte message at each entry's offset
+    BitSequence outputs[sizeof(lengths) / sizeof(lengths[0])][64];
+    BitSequence expected[64];
+    HashBatchEntry entries[sizeof(lengths) / sizeof(lengths[0])];
+
+    FillPattern(input, sizeof(input));
+
+    size_t i;
+    for(i = 0; i < count; i++) {
+        entries[i].data = input + i;
+        entries[i].dataBitLen = lengths[i];
+        entries[i].hashVal = outputs[i];
+    }
+
+    HashBatch(N, entries, count);
+
+    for(i = 0; i < count; i++) {
+        Hash(N, input + i, lengths[i], expected);
+
+        if(memcmp(outputs[i], expected, N/8) != 0) {
+            printf(RED_COLOR "HashBatch differs from Hash for a %d-bit message\n" RESET_COLOR, (uint32_t) lengths[i]);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    // Ten back-to-back 32-byte and 64-byte messages, then four 200-byte messages
+    static const uint32_t fixedLengths[] = {32, 64, 200};
+    BitSequence fixedOutputs[10 * 64];
+
+    uint32_t j;
+    for(j = 0; j < 3; j++) {
+        size_t fixedCount = 1000 / fixedLengths[j] < 10 ? 1000 / fixedLengths[j] : 10;
+
+        HashBatchFixed(N, input, (DataLength) fixedLengths[j] * 8, fixedCount, fixedOutputs);
+
+        for(i = 0; i < fixedCount; i++) {
+            Hash(N, input + (i * fixedLengths[j]), (DataLength) fixedLengths[j] * 8, expected);
+
+            if(memcmp(fixedOutputs + (i * N/8), expected, N/8) != 0) {
+                printf(RED_COLOR "HashBatchFixed differs from Hash for message %d of %d bytes\n" RESET_COLOR,
+                       (uint32_t) i, fixedLengths[j]);
+                printf("Test failed\n\n");
+                return 1;
+            }
+        }
+    }
+
+    printf("Test passed\n\n");
+    return 0;
+}
+
+/**
+  * Keccak[rate] with a suffix 0x1F, absorbing and squeezing a block at a time with the generic state functions.
+  */
+static void SpongeByBlocks(uint32_t rate, const BitSequence * data, uint32_t dataByteLen,
+                           BitSequence * output, uint32_t outputByteLen)
+{
+    SpongeMatrix state;
+    uint8_t padding[KeccakMaximumRateInBytes];
+    uint32_t tailLength = dataByteLen % (rate/8);
+
+    KeccakInitialize(state);
+    for(; dataByteLen >= rate/8; dataByteLen -= rate/8, data += rate/8) {
+        KeccakXorBytesIntoState(state, data, 0, rate/8);
+        KeccakPermutation(state);
+    }
+
+    memset(padding, 0, sizeof(padding));
+    memcpy(padding, data, tailLength);
+    padding[tailLength] ^= 0x1F;
+    padding[rate/8 - 1] ^= 0x80;
+    KeccakXorBytesIntoState(state, padding, 0, rate/8);
+    KeccakPermutation(state);
+
+    for(; outputByteLen > rate/8; outputByteLen -= rate/8, output += rate/8) {
+        KeccakExtractBytes(state, output, 0, rate/8);
+        KeccakPermutation(state);
+    }
+    KeccakExtractBytes(state, output, 0, outputByteLen);
+}
+
+uint32_t TestRateSpecializedSponge(uint32_t rate)
+{
+    printf("Comparing the sponge at r=%d with the generic block functions\n", rate);
+
+    const uint32_t rateInBytes = rate / 8;
+    const uint32_t dataLens[] = {0, 1, 32, 64, rateInBytes - 1, rateInBytes, rateInBytes + 1, rateInBytes + 32, 3 * rateInBytes + 7};
+    const uint32_t outputLens[] = {28, 32, 64, rateInBytes, 2 * rateInBytes + 5};
+    BitSequence input[3 * KeccakMaximumRateInBytes + 7];
+    BitSequence output[3 * KeccakMaximumRateInBytes];
+    BitSequence expected[3 * KeccakMaximumRateInBytes];
+    SpongeMatrix matrix;
+    SpongeState state;
+    uint32_t failed = 0;
+    uint32_t i;
+    uint32_t j;
+
+    FillPattern(input, sizeof(input));
+
+    for(i = 0; i < sizeof(dataLens) / sizeof(dataLens[0]); i++) {
+        for(j = 0; j < sizeof(outputLens) / sizeof(outputLens[0]); j++) {
+            SpongeByBlocks(rate, input, dataLens[i], expected, outputLens[j]);
+
+            SpongeOneShot(matrix, rate, SHAKEDelimitedSuffix, input, dataLens[i], output, outputLens[j]);
+            failed |= memcmp(output, expected, outputLens[j]) != 0;
+
+            // One byte opens a block, the rest completes it; the output starts with 3 bytes
+            InitSponge(&state, rate, 1600 - rate);
+            state.delimitedSuffix = SHAKEDelimitedSuffix;
+            AbsorbBytes(&state, input, dataLens[i] > 0);
+            AbsorbBytes(&state, input + (dataLens[i] > 0), dataLens[i] - (dataLens[i] > 0));
+            Squeeze(&state, output, 3 * 8);
+            Squeeze(&state, output + 3, (outputLens[j] - 3) * 8);
+            failed |= memcmp(output, expected, outputLens[j]) != 0;
+        }
+    }
+
+    if(failed) {
+        printf(RED_COLOR "The specialized loops differ from the generic ones\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    printf(GREEN_COLOR "One-shot and incremental outputs match\n" RESET_COLOR);
+    printf("Test passed\n\n");
+    return 0;
+}
+
+uint32_t TestParallelHash(uint32_t securityStrength, const BitSequence * sample, uint32_t inputDataLen, uint32_t blockByteLen,
+                          char * customization, uint32_t outputBitLen, int32_t xof, char * expectedOutput)
+{
+    printf("Running ParallelHash%s%d on %d-byte pattern with B = %d and S = \"%s\", serially and on 4 threads\n",
+           xof ? "XOF" : "", securityStrength, inputDataLen, blockByteLen, customization);
+
+    BitSequence * input = malloc(inputDataLen);
+    BitSequence output[64];
+    BitSequence threadedOutput[64];
+    char outputBuf[129];
+
+    // The given sample, or the usual pattern when there is none
+    if(sample != NULL) {
+        memcpy(input, sample, inputDataLen);
+    } else {
+        FillPattern(input, inputDataLen);
+    }
+
+    KeccakThreadPool * pool = KeccakThreadPoolCreate(4);
+
+    ParallelHash(securityStrength, input, inputDataLen, blockByteLen, (const uint8_t *) customization,
+                 strlen(customization), output, outputBitLen, xof, NULL);
+    ParallelHash(securityStrength, input, inputDataLen, blockByteLen, (const uint8_t *) customization,
+                 strlen(customization), threadedOutput, outputBitLen, xof, pool);
+
+    KeccakThreadPoolDestroy(pool);
+    free(input);
+
+    if(memcmp(output, threadedOutput, outputBitLen/8) != 0) {
+        printf(RED_COLOR "The thread pool changed the output\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    ToHex(output, outputBitLen/8, outputBuf);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestKeccakConstants()
+{
+    printf("Checking round constants and rho offsets against the LFSR\n");
+
+    if(KeccakVerifyConstants()) {
+        printf("Test passed\n\n");
+        return 0;
+    } else {
+        printf(RED_COLOR "Constant tables do not match the LFSR\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+}
+
+uint32_t TestKeccakPermutation(char * name, void (*permutation)(SpongeMatrix))
+{
+    // KeccakF[1600] applied once to the all-zero state, lanes in order x + 5y
+    static const uint64_t expected[nrLanes] = {
+        0xF1258F7940E1DDE7ULL, 0x84D5CCF933C0478AULL, 0xD598261EA65AA9EEULL, 0xBD1547306F80494DULL,
+        0x8B284E056253D057ULL, 0xFF97A42D7F8E6FD4ULL, 0x90FEE5A0A44647C4ULL, 0x8C5BDA0CD6192E76ULL,
+        0xAD30A6F71B19059CULL, 0x30935AB7D08FFC64ULL, 0xEB5AA93F2317D635ULL, 0xA9A6E6260D712103ULL,
+        0x81A57C16DBCF555FULL, 0x43B831CD0347C826ULL, 0x01F22F1A11A5569FULL, 0x05E5635A21D9AE61ULL,
+        0x64BEFEF28CC970F2ULL, 0x613670957BC46611ULL, 0xB87C5A554FD00ECBULL, 0x8C3EE88A1CCF32C8ULL,
+        0x940C7922AE3A2614ULL, 0x1841F924A2C509E4ULL, 0x16F53526E70465C2ULL, 0x75F644E97F30A13BULL,
+        0xEAF1FF7B5CECA249ULL,
+    };
+
+    printf("Checking %s permutation against the reference\n", name);
+
+    SpongeMatrix state;
+    SpongeMatrix referenceState;
+    memset(state, 0, sizeof(state));
+    memset(referenceState, 0, sizeof(referenceState));
+
+    permutation(state);
+
+    uint32_t i;
+    for(i = 0; i < nrLanes; i++) {
+        if(state[i % 5][i / 5] != expected[i]) {
+            printf(RED_COLOR "Lane %d differs from the known answer\n" RESET_COLOR, i);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    // Chain further permutations from the known answer and compare bit-for-bit
+    memcpy(referenceState, state, sizeof(state));
+
+    uint32_t iteration;
+    for(iteration = 0; iteration < 100; iteration++) {
+        state[iteration % 5][(iteration / 5) % 5] ^= iteration * 0x9E3779B97F4A7C15ULL;
+        referenceState[iteration % 5][(iteration / 5) % 5] ^= iteration * 0x9E3779B97F4A7C15ULL;
+
+        permutation(state);
+        KeccakPermutationReference(referenceState);
+
+        if(memcmp(state, referenceState, sizeof(state)) != 0) {
+            printf(RED_COLOR "Output differs from the reference after %d permutations\n" RESET_COLOR, iteration + 2);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    printf("Test passed\n\n");
+    return 0;
+}
+
+uint32_t TestKeccakPermutationRounds(char * name, void (*permutationRounds)(SpongeMatrix, uint32_t))
+{
+    // Keccak-p[1600, 12] applied once to the all-zero state, lanes in order x + 5y
+    static const uint64_t expected[nrLanes] = {
+        0x8E5E5438B9A78617ULL, 0xD9CD6A50F259D01EULL, 0x87B8E7C652A91F35ULL, 0x1093E067CDE4E0C5ULL,
+        0xB033AB90F2D95A45ULL, 0xE0A72F72A8DD1A45ULL, 0xC53780AA14672F9CULL, 0x3EDD47F50051071DULL,
+        0xB3A31D310C178ACCULL, 0x79B586A59257AAA0ULL, 0xBC4A7C3DB3B1F99BULL, 0x68874063E68A6793ULL,
+        0x5C6C03332E0E2566ULL, 0x9CAA1202B9F030DAULL, 0x5F3B9A782BCF7A9FULL, 0xE536C1E061AE7923ULL,
+        0x6DE9B618B73C87ECULL, 0x2ABED1F170918AC2ULL, 0x6AABBD53DAED24B7ULL, 0xBFC1416A2C2EE15AULL,
+        0xC6CFE036B90952AFULL, 0x45503617DC7060D7ULL, 0x625611B2C29F7AE4ULL, 0xD43671DB2C30647AULL,
+        0xCFFD0D76222CA01CULL,
+    };
+
+    printf("Checking %s Keccak-p[1600, n] permutation against the reference\n", name);
+
+    SpongeMatrix state;
+    SpongeMatrix referenceState;
+    memset(state, 0, sizeof(state));
+
+    permutationRounds(state, 12);
+
+    uint32_t i;
+    for(i = 0; i < nrLanes; i++) {
+        if(state[i % 5][i / 5] != expected[i]) {
+            printf(RED_COLOR "Lane %d differs from the known answer\n" RESET_COLOR, i);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    // Every round count, odd ones included, against the reference
+    memcpy(referenceState, state, sizeof(state));
+
+    uint32_t rounds;
+    for(rounds = 1; rounds <= nrRounds; rounds++) {
+        permutationRounds(state, rounds);
+        KeccakPermutationRoundsReference(referenceState, rounds);
+
+        if(memcmp(state, referenceState, sizeof(state)) != 0) {
+            printf(RED_COLOR "Output differs from the reference with %d rounds\n" RESET_COLOR, rounds);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    printf("Test passed\n\n");
+    return 0;
+}
+
+uint32_t TestTurboSHAKE(uint32_t securityStrength, uint32_t inputDataLen, uint8_t domainSeparation,
+                        uint32_t outputBitLen, char * expectedOutput)
+{
+    printf("Running TurboSHAKE%d on %d-byte pattern with D = %02x\n", securityStrength, inputDataLen, domainSeparation);
+
+    BitSequence * input = malloc(inputDataLen + 1);
+    BitSequence output[64];
+    char outputBuf[129];
+
+    FillPattern(input, inputDataLen);
+
+    TurboSHAKE(securityStrength, input, inputDataLen, domainSeparation, output, outputBitLen);
+
+    ToHex(output, outputBitLen/8, outputBuf);
+    free(input);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestKangarooTwelve(uint32_t inputDataLen, uint32_t customizationLen, uint32_t outputBitLen,
+                            char * expectedOutput)
+{
+    printf("Running KangarooTwelve on %d-byte pattern with a %d-byte pattern as C, serially and on 4 threads\n",
+           inputDataLen, customizationLen);
+
+    BitSequence * input = malloc(inputDataLen + 1);
+    BitSequence * customization = malloc(customizationLen + 1);
+    BitSequence output[64];
+    BitSequence threadedOutput[64];
+    char outputBuf[129];
+
+    FillPattern(input, inputDataLen);
+    FillPattern(customization, customizationLen);
+
+    KeccakThreadPool * pool = KeccakThreadPoolCreate(4);
+
+    KangarooTwelve(input, inputDataLen, customization, customizationLen, output, outputBitLen, NULL);
+    KangarooTwelve(input, inputDataLen, customization, customizationLen, threadedOutput, outputBitLen, pool);
+
+    KeccakThreadPoolDestroy(pool);
+    free(customization);
+    free(input);
+
+    if(memcmp(output, threadedOutput, outputBitLen/8) != 0) {
+        printf(RED_COLOR "The thread pool changed the output\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    ToHex(output, outputBitLen/8, outputBuf);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestSHA3(uint32_t hashBitLen, const BitSequence * data, uint32_t dataBitLen, char * expectedOutput)
+{
+    printf("Running SHA3-%d on a %d-bit message\n", hashBitLen, dataBitLen);
+
+    SpongeState state;
+    BitSequence output[64];
+    BitSequence oneShotOutput[64];
+    char outputBuf[129];
+
+    InitSHA3(&state, hashBitLen);
+    Absorb(&state, data, dataBitLen);
+    Squeeze(&state, output, hashBitLen);
+
+    if((dataBitLen % 8) == 0) {
+        SHA3(hashBitLen, data, dataBitLen/8, oneShotOutput);
+
+        if(memcmp(output, oneShotOutput, hashBitLen/8) != 0) {
+            printf(RED_COLOR "SHA3() and the incremental interface differ\n" RESET_COLOR);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    ToHex(output, hashBitLen/8, outputBuf);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestSHAKE(uint32_t securityStrength, uint32_t inputDataLen, uint32_t outputByteLen, char * expectedOutput)
+{
+    printf("Running SHAKE%d on %d-byte pattern, squeezing %d bytes in uneven pieces, last 32 bytes:\n",
+           securityStrength, inputDataLen, outputByteLen);
+
+    static const uint32_t pieces[] = {1, 167, 504, 7, 1000, 136, 2};
+    SpongeState state;
+    BitSequence * input = malloc(inputDataLen + 1);
+    BitSequence * output = malloc(outputByteLen);
+    BitSequence * oneShotOutput = malloc(outputByteLen);
+    char outputBuf[65];
+    uint32_t offset = 0;
+    uint32_t piece = 0;
+
+    FillPattern(input, inputDataLen);
+
+    SHAKE(securityStrength, input, inputDataLen, oneShotOutput, outputByteLen * 8);
+
+    InitSHAKE(&state, securityStrength);
+    Absorb(&state, input, inputDataLen * 8);
+
+    while(offset < outputByteLen) {
+        uint32_t length = pieces[piece++ % (sizeof(pieces) / sizeof(pieces[0]))];
+        if(length > outputByteLen - offset) {
+            length = outputByteLen - offset;
+        }
+        Squeeze(&state, output + offset, length * 8);
+        offset += length;
+    }
+
+    uint32_t same = memcmp(output, oneShotOutput, outputByteLen) == 0;
+    ToHex(output + outputByteLen - 32, 32, outputBuf);
+
+    free(oneShotOutput);
+    free(output);
+    free(input);
+
+    if(!same) {
+        printf(RED_COLOR "SHAKE() and the incremental interface differ\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestCloneSponge(uint32_t prefixLen)
+{
+    printf("Running SHAKE256 on clones of a sponge that absorbed a %d-byte prefix\n", prefixLen);
+
+    static const uint32_t messageLens[] = {0, 1, 135, 136, 300};
+    SpongeState snapshot;
+    SpongeState clone;
+    SpongeState squeezingClone;
+    BitSequence * input = malloc(prefixLen + 300);
+    BitSequence output[300];
+    BitSequence expected[300];
+    uint32_t failed = 0;
+    uint32_t i;
+
+    FillPattern(input, prefixLen + 300);
+
+    InitSHAKE(&snapshot, 256);
+    Absorb(&snapshot, input, prefixLen * 8);
+
+    for(i = 0; i < sizeof(messageLens) / sizeof(messageLens[0]); i++) {
+        CloneSponge(&clone, &snapshot);
+        Absorb(&clone, input + prefixLen, messageLens[i] * 8);
+        Squeeze(&clone, output, 64 * 8);
+
+        SHAKE256(input, prefixLen + messageLens[i], expected, 64 * 8);
+        failed |= memcmp(output, expected, 64) != 0;
+    }
+
+    // A squeezing clone continues from the same output position
+    CloneSponge(&clone, &snapshot);
+    Squeeze(&clone, output, 10 * 8);
+    CloneSponge(&squeezingClone, &clone);
+    Squeeze(&clone, output + 10, 290 * 8);
+    Squeeze(&squeezingClone, expected, 290 * 8);
+    failed |= memcmp(output + 10, expected, 290) != 0;
+
+    SHAKE256(input, prefixLen, expected, 300 * 8);
+    failed |= memcmp(output, expected, 300) != 0;
+
+    free(input);
+
+    if(failed) {
+        printf(RED_COLOR "A clone did not continue as the original sponge\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    printf(GREEN_COLOR "Clones match fresh sponges\n" RESET_COLOR);
+    printf("Test passed\n\n");
+    return 0;
+}
+
+uint32_t TestSpongeArena(uint32_t nrContexts, uint32_t messageLen)
+{
+    printf("Running SHA3-256 on %d interleaved %d-byte messages in arena contexts of %d bytes\n",
+           nrContexts, messageLen, (uint32_t) sizeof(SpongeState));
+
+    SpongeArena * arena = SpongeArenaCreate(64);
+    SpongeState ** contexts = malloc(nrContexts * sizeof(SpongeState *));
+    BitSequence * input = malloc(nrContexts + messageLen);
+    BitSequence output[32];
+    BitSequence expected[32];
+    uint32_t failed = 0;
+    uint32_t i;
+    uint32_t offset;
+
+    FillPattern(input, nrContexts + messageLen);
+
+    // Message i starts at byte i of the pattern, and every message gets one byte at a time
+    for(i = 0; i < nrContexts; i++) {
+        contexts[i] = SpongeArenaAllocate(arena);
+        failed |= ((uintptr_t) contexts[i] % KeccakSpongeStateAlignment) != 0;
+        InitSHA3(contexts[i], 256);
+    }
+
+    for(offset = 0; offset < messageLen; offset++) {
+        for(i = 0; i < nrContexts; i++) {
+            Absorb(contexts[i], input + i + offset, 8);
+        }
+    }
+
+    for(i = 0; i < nrContexts; i++) {
+        Squeeze(contexts[i], output, 256);
+        SHA3(256, input + i, messageLen, expected);
+        failed |= memcmp(output, expected, 32) != 0;
+    }
+
+    // Freed contexts are handed out again, the last freed first
+    uint32_t lastFreed = 0;
+    for(i = 0; i < nrContexts; i += 2) {
+        SpongeArenaFree(arena, contexts[i]);
+        lastFreed = i;
+    }
+    for(i = 0; i <= lastFreed; i += 2) {
+        failed |= SpongeArenaAllocate(arena) != contexts[lastFreed - i];
+    }
+
+    SpongeArenaDestroy(arena);
+    free(input);
+    free(contexts);
+
+    if(failed) {
+        printf(RED_COLOR "Arena contexts were misaligned, not reused or hashed wrongly\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    printf(GREEN_COLOR "All contexts aligned, reused and matching SHA3()\n" RESET_COLOR);
+    printf("Test passed\n\n");
+    return 0;
+}
+
+#define ConcurrentMessages 64
+
+typedef struct {
+    const BitSequence * input;
+    BitSequence * outputs;      // Per hashing task, ConcurrentMessages SHA3-256 and SHAKE128 outputs of 64 bytes
+} ConcurrentContext;
+
+static void HashConcurrentMessages(const BitSequence * input, BitSequence * outputs)
+{
+    SpongeState state;
+    uint32_t i;
+
+    for(i = 0; i < ConcurrentMessages; i++) {
+        Hash(256, input, i * 37 * 8, outputs + i * 64);
+
+        InitSHAKE(&state, 128);
+        AbsorbBytes(&state, input, i * 53);
+        Squeeze(&state, outputs + i * 64 + 32, 32 * 8);
+    }
+}
+
+static void ConcurrentTask(void * context, uint64_t index)
+{
+    ConcurrentContext * test = context;
+
+    if (index == 0) {
+        // One task keeps switching the backend while the others hash
+        uint32_t backendCount;
+        const KeccakBackend * backends = KeccakListBackends(&backendCount);
+        uint32_t round;
+        uint32_t i;
+
+        for(round = 0; round < 100; round++) {
+            for(i = 0; i < backendCount; i++) {
+                KeccakSelectBackend(backends[i].name);
+            }
+        }
+    }
+    else {
+        HashConcurrentMessages(test->input, test->outputs + (index - 1) * ConcurrentMessages * 64);
+    }
+}
+
+uint32_t TestConcurrentHashing(uint32_t nrThreads, uint32_t nrTasks)
+{
+    printf("Running %d hashing tasks on %d threads while switching backends, against serial output\n",
+           nrTasks, nrThreads);
+
+    const char * backendName = KeccakGetBackend()->name;
+    BitSequence * input = malloc(ConcurrentMessages * 53);
+    BitSequence * expected = malloc(ConcurrentMessages * 64);
+    BitSequence * outputs = malloc((size_t) nrTasks * ConcurrentMessages * 64);
+    ConcurrentContext test;
+    uint32_t failed = 0;
+    uint32_t i;
+
+    FillPattern(input, ConcurrentMessages * 53);
+    HashConcurrentMessages(input, expected);
+
+    test.input = input;
+    test.outputs = outputs;
+
+    KeccakThreadPool * pool = KeccakThreadPoolCreate(nrThreads);
+    KeccakThreadPoolRun(pool, ConcurrentTask, &test, nrTasks + 1);
+    KeccakThreadPoolDestroy(pool);
+
+    KeccakSelectBackend(backendName);
+
+    for(i = 0; i < nrTasks; i++) {
+        failed |= memcmp(outputs + i * ConcurrentMessages * 64, expected, ConcurrentMessages * 64) != 0;
+    }
+
+    free(outputs);
+    free(expected);
+    free(input);
+
+    if(failed) {
+        printf(RED_COLOR "A thread computed a different hash\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    printf(GREEN_COLOR "All threads match the serial output\n" RESET_COLOR);
+    printf("Test passed\n\n");
+    return 0;
+}
+
+uint32_t TestMerkleTree(uint32_t dataLen, uint32_t leafLen, char * expectedOutput)
+{
+    printf("Running a Merkle tree over %d-byte pattern with %d-byte leaves, then updating three regions on 4 threads\n",
+           dataLen, leafLen);
+
+    BitSequence * data = malloc(dataLen + 1);
+    BitSequence root[KeccakMerkleTreeNodeByteLen];
+    BitSequence rebuiltRoot[KeccakMerkleTreeNodeByteLen];
+    char outputBuf[2 * KeccakMerkleTreeNodeByteLen + 1];
+
+    FillPattern(data, dataLen);
+
+    KeccakMerkleTree * tree = KeccakMerkleTreeCreate(dataLen, leafLen);
+    KeccakMerkleTreeUpdate(tree, data, NULL);
+    KeccakMerkleTreeRoot(tree, root);
+    ToHex(root, KeccakMerkleTreeNodeByteLen, outputBuf);
+
+    if(dataLen > 0) {
+        // The first byte, a range across a leaf boundary in the middle, and the last byte
+        uint32_t middle = dataLen / 2;
+        uint32_t middleLen = (dataLen - middle < leafLen + 2) ? dataLen - middle : leafLen + 2;
+
+        data[0] ^= 0xFF;
+        memset(data + middle, 0xA5, middleLen);
+        data[dataLen - 1] ^= 0x01;
+
+        KeccakMerkleTreeMarkDirty(tree, 0, 1);
+        KeccakMerkleTreeMarkDirty(tree, middle, middleLen);
+        KeccakMerkleTreeMarkDirty(tree, dataLen - 1, 1);
+
+        KeccakThreadPool * pool = KeccakThreadPoolCreate(4);
+        KeccakMerkleTreeUpdate(tree, data, pool);
+        KeccakThreadPoolDestroy(pool);
+        KeccakMerkleTreeRoot(tree, root);
+
+        KeccakMerkleTree * rebuilt = KeccakMerkleTreeCreate(dataLen, leafLen);
+        KeccakMerkleTreeUpdate(rebuilt, data, NULL);
+        KeccakMerkleTreeRoot(rebuilt, rebuiltRoot);
+        KeccakMerkleTreeDestroy(rebuilt);
+
+        if(memcmp(root, rebuiltRoot, KeccakMerkleTreeNodeByteLen) != 0) {
+            KeccakMerkleTreeDestroy(tree);
+            free(data);
+            printf(RED_COLOR "The updated tree differs from a rebuilt one\n" RESET_COLOR);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    KeccakMerkleTreeDestroy(tree);
+    free(data);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestcSHAKE(uint32_t securityStrength, uint32_t inputDataLen, char * customization,
+                    uint32_t outputBitLen, char * expectedOutput)
+{
+    printf("Running cSHAKE%d on bytes 00..%02x with S = \"%s\"\n", securityStrength, inputDataLen - 1, customization);
+
+    BitSequence input[256];
+    BitSequence output[64];
+    char outputBuf[129];
+    uint32_t i;
+
+    for(i = 0; i < inputDataLen; i++) {
+        input[i] = i;
+    }
+
+    cSHAKE(securityStrength, input, inputDataLen, NULL, 0,
+           (const BitSequence *) customization, strlen(customization), output, outputBitLen);
+
+    ToHex(output, outputBitLen/8, outputBuf);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestKMAC(uint32_t securityStrength, uint32_t inputDataLen, char * customization,
+                  uint32_t outputBitLen, int32_t xof, char * expectedOutput)
+{
+    printf("Running KMAC%s%d with key 40..5f on bytes 00..%02x with S = \"%s\", one-shot and from a reused key state\n",
+           xof ? "XOF" : "", securityStrength, inputDataLen - 1, customization);
+
+    BitSequence key[32];
+    BitSequence input[256];
+    BitSequence output[64];
+    BitSequence keyStateOutput[64];
+    char outputBuf[129];
+    SpongeState keyState;
+    uint32_t failed = 0;
+    uint32_t i;
+
+    for(i = 0; i < sizeof(key); i++) {
+        key[i] = 0x40 + i;
+    }
+    for(i = 0; i < inputDataLen; i++) {
+        input[i] = i;
+    }
+
+    KMAC(securityStrength, key, sizeof(key), input, inputDataLen,
+         (const BitSequence *) customization, strlen(customization), output, outputBitLen, xof);
+
+    // The key state is used several times, for other messages in between
+    InitKMAC(&keyState, securityStrength, key, sizeof(key), (const BitSequence *) customization, strlen(customization));
+
+    for(i = 0; i < 3; i++) {
+        KMACFromKeyState(&keyState, input, (i == 1) ? inputDataLen / 2 : inputDataLen, keyStateOutput, outputBitLen, xof);
+        failed |= (i != 1) && (memcmp(output, keyStateOutput, outputBitLen/8) != 0);
+    }
+
+    // A finished state cannot be finished again
+    SpongeState finished;
+    CloneSponge(&finished, &keyState);
+    failed |= (FinalKMAC(&finished, keyStateOutput, outputBitLen, xof) != SUCCESS);
+    failed |= (FinalKMAC(&finished, keyStateOutput, outputBitLen, xof) != MODE_IS_SQUEEZING);
+    EraseKMAC(&finished);
+
+    EraseKMAC(&keyState);
+
+    if(failed) {
+        printf(RED_COLOR "KMACFromKeyState() and KMAC() differ, or FinalKMAC() finished a state twice\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    ToHex(output, outputBitLen/8, outputBuf);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestTupleHash(uint32_t securityStrength, uint32_t tupleLength, char * customization,
+                       uint32_t outputBitLen, int32_t xof, char * expectedOutput)
+{
+    printf("Running TupleHash%s%d on a %d-element tuple with S = \"%s\"\n",
+           xof ? "XOF" : "", securityStrength, tupleLength, customization);
+
+    static const BitSequence element1[] = {0x00, 0x01, 0x02};
+    static const BitSequence element2[] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15};
+    static const BitSequence element3[] = {0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28};
+    SP800185String tuple[3];
+    BitSequence output[64];
+    char outputBuf[129];
+
+    tuple[0].data = element1;
+    tuple[0].byteLen = sizeof(element1);
+    tuple[1].data = element2;
+    tuple[1].byteLen = sizeof(element2);
+    tuple[2].data = element3;
+    tuple[2].byteLen = sizeof(element3);
+
+    TupleHash(securityStrength, tuple, tupleLength, (const BitSequence *) customization, strlen(customization),
+              output, outputBitLen, xof);
+
+    ToHex(output, outputBitLen/8, outputBuf);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestDRBG(uint32_t securityStrength, char * personalization, const uint32_t * requests, uint32_t nrRequests,
+                  char * expectedOutput)
+{
+    printf("Running the DRBG at strength %d seeded with 00..2f, SHA3-256 of the output of %d requests:\n",
+           securityStrength, nrRequests);
+
+    KeccakDRBG drbg;
+    SpongeState digest;
+    BitSequence seed[48];
+    BitSequence * output = malloc(3 * KeccakDRBGBufferByteLen);
+    BitSequence digestOutput[32];
+    char outputBuf[65];
+    uint32_t i;
+
+    for(i = 0; i < sizeof(seed); i++) {
+        seed[i] = i;
+    }
+
+    KeccakDRBGInstantiate(&drbg, securityStrength, seed, sizeof(seed),
+                          (const BitSequence *) personalization, strlen(personalization));
+    InitSHA3(&digest, 256);
+
+    // A request of 0 bytes stands for a reseed with "entropy"
+    for(i = 0; i < nrRequests; i++) {
+        if(requests[i] == 0) {
+            KeccakDRBGReseed(&drbg, (const BitSequence *) "entropy", 7);
+        }
+        else {
+            KeccakDRBGGenerate(&drbg, output, requests[i]);
+            AbsorbBytes(&digest, output, requests[i]);
+        }
+    }
+
+    Squeeze(&digest, digestOutput, 256);
+    KeccakDRBGErase(&drbg);
+    free(output);
+
+    ToHex(digestOutput, 32, outputBuf);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestSpongeWrap(char * expectedOutput)
+{
+    printf("Running a SpongeWrap session of four messages, unwrapping them in place, then short tags and a forged tag. SHA3-256 of ciphertexts and tags:\n");
+
+    // Associated data, plaintext and tag lengths of each message, around the block size
+    static const uint32_t lengths[4][3] = {{12, 0, 16}, {0, 1, 16}, {135, 135, 32}, {300, 1000, 200}};
+    KeccakSpongeWrap sender;
+    KeccakSpongeWrap receiver;
+    SpongeState digest;
+    BitSequence key[32];
+    BitSequence associatedData[300];
+    BitSequence plaintext[1000];
+    BitSequence message[1000];
+    BitSequence tag[200];
+    BitSequence digestOutput[32];
+    char outputBuf[65];
+    uint32_t failed = 0;
+    uint32_t i;
+
+    for(i = 0; i < sizeof(key); i++) {
+        key[i] = i;
+    }
+    FillPattern(associatedData, sizeof(associatedData));
+    FillPattern(plaintext, sizeof(plaintext));
+
+    SpongeWrapInitialize(&sender, key, sizeof(key));
+    SpongeWrapInitialize(&receiver, key, sizeof(key));
+    InitSHA3(&digest, 256);
+
+    for(i = 0; i < 4; i++) {
+        SpongeWrapWrap(&sender, associatedData, lengths[i][0], plaintext, lengths[i][1], message, tag, lengths[i][2]);
+        AbsorbBytes(&digest, message, lengths[i][1]);
+        AbsorbBytes(&digest, tag, lengths[i][2]);
+
+        failed |= SpongeWrapUnwrap(&receiver, associatedData, lengths[i][0], message, lengths[i][1],
+                                   message, tag, lengths[i][2]) != SUCCESS;
+        failed |= memcmp(message, plaintext, lengths[i][1]) != 0;
+    }
+
+    // Empty and short tags are refused without touching either session
+    failed |= SpongeWrapWrap(&sender, associatedData, 10, plaintext, 10, message, tag, 0) != BAD_HASHLEN;
+    failed |= SpongeWrapWrap(&sender, associatedData, 10, plaintext, 10, message, tag, KeccakSpongeWrapMinTagByteLen - 1) != BAD_HASHLEN;
+    failed |= SpongeWrapUnwrap(&receiver, associatedData, 10, message, 10, message, tag, 0) != BAD_HASHLEN;
+    failed |= SpongeWrapUnwrap(&receiver, associatedData, 10, message, 10, message, tag, 8) != BAD_HASHLEN;
+
+    // A forged tag is rejected, the plaintext erased and the session closed
+    SpongeWrapWrap(&sender, associatedData, 10, plaintext, 10, message, tag, 16);
+    tag[15] ^= 0x01;
+    failed |= SpongeWrapUnwrap(&receiver, associatedData, 10, message, 10, message, tag, 16) != FAIL;
+    for(i = 0; i < 10; i++) {
+        failed |= message[i] != 0;
+    }
+    failed |= SpongeWrapWrap(&receiver, associatedData, 10, plaintext, 10, message, tag, 16) != FAIL;
+
+    SpongeWrapErase(&sender);
+    SpongeWrapErase(&receiver);
+
+    Squeeze(&digest, digestOutput, 256);
+
+    if(failed) {
+        printf(RED_COLOR "Unwrapping did not invert wrapping or accepted a short or forged tag\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    ToHex(digestOutput, 32, outputBuf);
+
+    return CheckOutput(outputBuf, expectedOutput);
+}
+
+uint32_t TestEraseState(void)
+{
+    printf("Erasing a sponge context that absorbed a secret, and a KMAC key state\n");
+
+    SpongeState state;
+    const uint8_t * bytes = (const uint8_t *) &state;
+    uint8_t nonZero = 0;
+    size_t i;
+
+    InitSHAKE(&state, 256);
+    Absorb(&state, (const BitSequence *) "secret key material", 19 * 8);
+    EraseState(&state);
+
+    for(i = 0; i < sizeof(state); i++) {
+        nonZero |= bytes[i];
+    }
+
+    // Nothing is cleared when the library is built for public data only
+    if((KECCAK_ERASE_POLICY != KECCAK_ERASE_NONE) && (nonZero != 0)) {
+        printf(RED_COLOR "The erased context still holds data\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    // A KMAC key state is cleared under every policy
+    uint8_t key[32] = {0x40};
+    InitKMAC(&state, 256, key, sizeof(key), NULL, 0);
+    EraseKMAC(&state);
+
+    for(i = 0; i < sizeof(state); i++) {
+        if (bytes[i] != 0) {
+            printf(RED_COLOR "The erased KMAC key state still holds data\n" RESET_COLOR);
+            printf("Test failed\n\n");
+            return 1;
+        }
+    }
+
+    printf(GREEN_COLOR "Context cleared as the erasure policy requires\n" RESET_COLOR);
+    printf("Test passed\n\n");
+    return 0;
+}
+
+#if defined(KECCAK_INSTRUMENTATION)
+uint32_t TestInstrumentation(void)
+{
+    printf("Counting the blocks and bytes of incremental SHA3-256 and SHAKE128\n");
+
+    SpongeState state;
+    KeccakCounters counters;
+    BitSequence input[1010];
+    BitSequence output[200];
+    uint32_t failed = 0;
+
+    FillPattern(input, sizeof(input));
+
+    // 10 bytes open a block, 126 complete it, then 6 whole blocks and 58 bytes of a last one
+    KeccakCountersReset();
+    InitSHA3(&state, 256);
+    Absorb(&state, input, 10 * 8);
+    Absorb(&state, input + 10, 1000 * 8);
+    Squeeze(&state, output, 32 * 8);
+    KeccakCountersSnapshot(&counters);
+
+    failed |= counters.permutations != 8;
+    failed |= counters.fastPathBytes != 6 * 136;
+    failed |= counters.fastPathBlocks != 6;
+    failed |= counters.partialBlockBytes != 10 + 126 + 58;
+    failed |= counters.paddingBlocks != 0;
+    failed |= counters.squeezedBytes != 32;
+    failed |= counters.permutationNanoseconds == 0;
+    failed |= counters.absorbNanoseconds == 0;
+
+    // With one bit left in the block the SHAKE suffix spills into another block,
+    // and the 200 bytes of output take a second block
+    KeccakCountersReset();
+    InitSHAKE(&state, 128);
+    Absorb(&state, input, 168 * 8 - 1);
+    Squeeze(&state, output, 200 * 8);
+    KeccakCountersSnapshot(&counters);
+
+    failed |= counters.permutations != 3;
+    failed |= counters.paddingBlocks != 1;
+    failed |= counters.partialBlockBytes != 168;
+    failed |= counters.squeezedBytes != 200;
+
+    if(failed) {
+        printf(RED_COLOR "The counters do not match the blocks and bytes processed\n" RESET_COLOR);
+        printf("Test failed\n\n");
+        return 1;
+    }
+
+    printf(GREEN_COLOR "Permutations, fast-path and partial-block bytes and padding blocks counted\n" RESET_COLOR);
+    printf("Test passed\n\n");
+    return 0;
+}
+#endif
+
 int main()
 {
     int testsFailed = 0;
 
+    testsFailed += TestKeccakConstants();
+
+    uint32_t backendCount;
+    const KeccakBackend * backends = KeccakListBackends(&backendCount);
+
+    uint32_t i;
+    for(i = 0; i < backendCount; i++) {
+        if(backends[i].isSupported()) {
+            testsFailed += TestKeccakPermutation((char *) backends[i].name, backends[i].permutation);
+            testsFailed += TestKeccakPermutationRounds((char *) backends[i].name, backends[i].permutationRounds);
+        }
+    }
+
+    printf("Running the remaining tests with the %s backend\n\n", KeccakGetBackend()->name);
+
+    testsFailed += TestKeccakTimesN(4, 24);
+
+    testsFailed += TestKeccakTimesN(4, 12);
+
+    testsFailed += TestKeccakTimesN(4, 7);
+
+    testsFailed += TestKeccakTimesN(8, 24);
+
+    testsFailed += TestKeccakTimesN(8, 12);
+
+    testsFailed += TestKeccakTimesN(8, 7);
+
     testsFailed += TestKeccakN(224, "", 0, "f71837502ba8e10837bdd8d365adb85591895602fc552b48b7390abd");
 
     testsFailed += TestKeccakN(256, "", 0, "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470");
@@ -65,7 +1242,147 @@ int main()
 
     testsFailed += TestKeccakN(256, "hello", 5, "1c8aff950685c2ed4bc3174f3472287b56d9517b9c948127319a09a7a36deac8");
 
+    testsFailed += TestKeccakStreaming(224, 1000, "bade992c46a5696b8e103d74ae6fb1fb4cddff57c276d2baf67565fc");
+
+    testsFailed += TestKeccakStreaming(256, 1000, "af692982e84a5a9688359025660a7857cd28ee7c8d867cfa1677baf2e6d1f63b");
+
+    testsFailed += TestKeccakStreaming(384, 1000, "f2c25e476fb2c046931f4cd056efaa2c85031876364a1d462c493eb2db2707805c59d7b4a23c0acd20e3ff8d20945022");
+
+    testsFailed += TestKeccakStreaming(512, 1000, "dec8169d40c30076041b00181c5fdfcc36b95f2acb6ff5bbaea772c37d91885b4c85b1463c718e9e6ffed3896c01d2aede2904c80c1fd6d6d4a5e87b991db490");
+
+    testsFailed += TestKeccakSqueeze(512, "1093a7a59d7261a52ff7480a7940c669a516952e4abcd891c958dcf3dee96a8f0aca9b477630e4372cda545aec270613195486f4218143f1ae2703e8c6bc6cd036117d23f426c3e8de0eec25fa7fb4076d53375534795fd2b0d42b6e99a1c0a9cbe6b129a1acd0b0ce9471cff61e0eff4688a928f158987b88cba899fab49f72aa44f6002cf7c825f6783750f098f7ebbbc59d396bd8db6b61a14b23761c847860be1637c9d4f4c51ff9591f6cd0af6831e8b75655085238e7cb5c44da0430656a0d189b5c97a8fe540f6ed0bb5fa0c5b2a56c991b4b198605536e2c6f5294238b6a24e6f498398a0c6f3db70207c1a2931883cee8eadc74b393915c5a08f3918446b33bd6d0169bb0febeb62f6e6bfd6a49b7fd067afb6b97fe8d4217916e3033dbb3a8b4f4e9a91eedccc58cad2db42ec4666ee990d0b14c50dbffe538272e2e33b0b5a424e8bbc0e36458727010f81a983ccd32ed7a164ee7f8363bc733f2c40d7c44766f00c4522fad9cff8942f1b45be6939b3d2fda213f7c94137af085517e429fcf89827b146c942b3c3ef1f6aa4dfca88f0d89b85cdefa200a53d27e7d3921096034580bb96eaf670988dcd039e16cb61cde1da30f7f4cd60f1e87be349df075be46e33bbab295d9ec0a20cca3b3cb43242bea082ad7a134af9501caf2672167b47004036a23d2dbe07652c869aa5be0022b8f2341d7fbfd7d50ba53");
+
+    testsFailed += TestRateSpecializedSponge(576);
+
+    testsFailed += TestRateSpecializedSponge(832);
+
+    testsFailed += TestRateSpecializedSponge(1088);
+
+    testsFailed += TestRateSpecializedSponge(1152);
+
+    testsFailed += TestRateSpecializedSponge(1344);
+
+    testsFailed += TestRateSpecializedSponge(1024);
+
+    testsFailed += TestHashBatch(224);
+
+    testsFailed += TestHashBatch(256);
+
+    testsFailed += TestHashBatch(384);
+
+    testsFailed += TestHashBatch(512);
+
+    // Input of the NIST ParallelHash samples
+    static const BitSequence parallelHashSample[24] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+        0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+    };
+
+    testsFailed += TestParallelHash(128, parallelHashSample, 24, 8, "", 256, 0, "ba8dc1d1d979331d3f813603c67f72609ab5e44b94a0b8f9af46514454a2b4f5");
+
+    testsFailed += TestParallelHash(128, parallelHashSample, 24, 8, "Parallel Data", 256, 0, "fc484dcb3f84dceedc353438151bee58157d6efed0445a81f165e495795b7206");
+
+    testsFailed += TestParallelHash(128, NULL, 300000, 1000, "Parallel Data", 256, 0, "f141c0cbd23c3dea9b79d6a5663b319929b7b7a1aa4e8027fd6eac5278890c23");
+
+    testsFailed += TestParallelHash(256, NULL, 300000, 8192, "", 512, 0, "42e9568b7b5a07f4ada2a82fa9ce9303c042facd8dac67e0e22d1f6c2efb7acba9548c321887b7be062816f4d783061add1f0bafd1610db98f84a1e74aebb892");
+
+    testsFailed += TestParallelHash(128, NULL, 20000, 1, "", 256, 1, "c793681736f9a56abb531cefebbd222129450be0705ea3b4ecd079410db0f82d");
+
+    testsFailed += TestcSHAKE(128, 4, "", 256, "0b0cc28e60e37698b411234b1158a5d42636440432a28e8b8df5be04208878f9");
+
+    testsFailed += TestcSHAKE(128, 4, "Email Signature", 256, "c1c36925b6409a04f1b504fcbca9d82b4017277cb5ed2b2065fc1d3814d5aaf5");
+
+    testsFailed += TestcSHAKE(256, 200, "Email Signature", 512, "07dc27b11e51fbac75bc7b3c1d983e8b4b85fb1defaf218912ac86430273091727f42b17ed1df63e8ec118f04b23633c1dfb1574c8fb55cb45da8e25afb092bb");
+
+    testsFailed += TestKMAC(128, 4, "", 256, 0, "e5780b0d3ea6f7d3a429c5706aa43a00fadbd7d49628839e3187243f456ee14e");
+
+    testsFailed += TestKMAC(128, 4, "My Tagged Application", 256, 0, "3b1fba963cd8b0b59e8c1a6d71888b7143651af8ba0a7070c0979e2811324aa5");
+
+    testsFailed += TestKMAC(256, 200, "My Tagged Application", 512, 0, "b58618f71f92e1d56c1b8c55ddd7cd188b97b4ca4d99831eb2699a837da2e4d970fbacfde50033aea585f1a2708510c32d07880801bd182898fe476876fc8965");
+
+    testsFailed += TestKMAC(256, 200, "My Tagged Application", 512, 1, "d5be731c954ed7732846bb59dbe3a8e30f83e77a4bff4459f2f1c2b4ecebb8ce67ba01c62e8ab8578d2d499bd1bb276768781190020a306a97de281dcc30305d");
+
+    testsFailed += TestTupleHash(128, 2, "", 256, 0, "c5d8786c1afb9b82111ab34b65b2c0048fa64e6d48e263264ce1707d3ffc8ed1");
+
+    testsFailed += TestTupleHash(128, 2, "My Tuple App", 256, 0, "75cdb20ff4db1154e841d758e24160c54bae86eb8c13e7f5f40eb35588e96dfb");
+
+    testsFailed += TestTupleHash(128, 3, "My Tuple App", 256, 0, "e60f202c89a2631eda8d4c588ca5fd07f39e5151998deccf973adb3804bb6e84");
+
+    testsFailed += TestTupleHash(256, 3, "My Tuple App", 512, 1, "0c59b11464f2336c34663ed51b2b950bec743610856f36c28d1d088d8a2446284dd09830a6a178dc752376199fae935d86cfdee5913d4922dfd369b66a53c897");
+
+    static const uint32_t drbgRequests[] = {16, 100, 2 * KeccakDRBGBufferByteLen + 5, 33, 0, 64, KeccakDRBGBufferByteLen};
+    testsFailed += TestDRBG(256, "test", drbgRequests, 7, "78f9632dffb0ce8b8a4bea8dcb8e153114a961e55bfa84288d6eafdae7d1a62d");
+
+    static const uint32_t drbgBufferRequests[] = {1, KeccakDRBGBufferByteLen - 1, KeccakDRBGBufferByteLen + 1};
+    testsFailed += TestDRBG(128, "", drbgBufferRequests, 3, "90ef1278e3a5996b35ab93224357768ac0d1821b101b56b6867091d9698056fe");
+
+    testsFailed += TestSpongeWrap("cb17d17b2e974ae9bd6d548eab03ecff1a296440b72c3157bb5db561a17a642a");
+
+    testsFailed += TestTurboSHAKE(128, 0, 0x1F, 256, "1e415f1c5983aff2169217277d17bb538cd945a397ddec541f1ce41af2c1b74c");
+
+    testsFailed += TestTurboSHAKE(256, 0, 0x1F, 512, "367a329dafea871c7802ec67f905ae13c57695dc2c6663c61035f59a18f8e7db11edc0e12e91ea60eb6b32df06dd7f002fbafabb6e13ec1cc20d995547600db0");
+
+    testsFailed += TestTurboSHAKE(128, 289, 0x06, 256, "f60392c729dc7928e8b2e36fed5bff8a5a4275cf377ca196483a8cb6ecae8a13");
+
+    testsFailed += TestTurboSHAKE(256, 1000, 0x0B, 512, "cccaefcac8ce2f2ed523c7af6c28234a6b7fe2c29dec58344859e8a12d71c97cb0cd6f027dd0a0e9b6b09da9e5feb9b7a3245ff1e20819000e5fac544dbf2da4");
+
+    testsFailed += TestKangarooTwelve(0, 0, 256, "1ac2d450fc3b4205d19da7bfca1b37513c0803577ac7167f06fe2ce1f0ef39e5");
+
+    testsFailed += TestKangarooTwelve(17, 0, 256, "6bf75fa2239198db4772e36478f8e19b0f371205f6a9a93a273f51df37122888");
+
+    testsFailed += TestKangarooTwelve(0, 1, 256, "fab658db63e94a246188bf7af69a133045f46ee984c56e3c3328caaf1aa1a583");
+
+    testsFailed += TestKangarooTwelve(4913, 0, 256, "cb552e2ec77d9910701d578b457ddf772c12e322e4ee7fe417f92c758f0d59d0");
+
+    testsFailed += TestKangarooTwelve(8192, 0, 256, "48f256f6772f9edfb6a8b661ec92dc93b95ebd05a08a17b39ae3490870c926c3");
+
+    testsFailed += TestKangarooTwelve(83521, 41, 256, "fa91321f401f438ce218b3803428f580e0e45297484c8e5a65ebf7f112c62d07");
+
+    testsFailed += TestKangarooTwelve(8000, 20000, 512, "a3053c2a2a1d72a49338a4e346811b0b8b81ccd911cffcd839cf94cdc489ce61c0fe94972fbc29d37d140cd7b03b5c45bf61f654a01a7b76861241358908f5f4");
+
+    testsFailed += TestKangarooTwelve(0, 10000, 256, "33ceb4ca9e5b2764f7a9af5513e41a0b8088572507aebcd9bdc6389159b01c9e");
+
+    testsFailed += TestKangarooTwelve(1419857, 0, 256, "844d610933b1b9963cbdeb5ae3b6b05cc7cbd67ceedf883eb678a0a8e0371682");
+
+    testsFailed += TestSHA3(224, (const BitSequence *) "abc", 24, "e642824c3f8cf24ad09234ee7d3c766fc9a3a5168d0c94ad73b46fdf");
+
+    testsFailed += TestSHA3(256, (const BitSequence *) "abc", 24, "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532");
+
+    testsFailed += TestSHA3(384, (const BitSequence *) "abc", 24, "ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c2596da7cf0e49be4b298d88cea927ac7f539f1edf228376d25");
+
+    // The 5-bit message 11001 from the NIST SHA3 examples
+    testsFailed += TestSHA3(224, (const BitSequence *) "\x13", 5, "ffbad5da96bad71789330206dc6768ecaeb1b32dca6b3301489674ab");
+
+    testsFailed += TestSHAKE(128, 1000, 4000, "75bd7f28656cf8558df968432811efa2146dc74458d31f70cba33a59a16f647a");
+
+    testsFailed += TestSHAKE(256, 135, 4000, "18d42c5305e46216b1437d167c9171ec1ea4cbee26840583172ec2363354a2ee");
+
+    testsFailed += TestSHAKE(256, 136, 4000, "18e01e04b7ab7efedbadc93ff24b314f7519bf41217acea422cdcea8ad2e858d");
+
+    testsFailed += TestCloneSponge(0);
+
+    testsFailed += TestCloneSponge(100);
+
+    testsFailed += TestCloneSponge(1000);
+
+    testsFailed += TestSpongeArena(1000, 300);
+
+    testsFailed += TestConcurrentHashing(8, 16);
+
+    testsFailed += TestMerkleTree(0, 4, "5d53469f20fef4f8eab52b88044ede69c77a6a68a60728609fc4a65ff531e7d0");
+
+    testsFailed += TestMerkleTree(10, 4, "1acb2d116b49941d762262018ee25cdad0302da6d959f76f603d2b0a2e90fe26");
+
+    testsFailed += TestMerkleTree(1000000, 4096, "0a12cfb4e066878278f8229e209abb273396e7db5e7f16cdd85b0d8d32ef40ac");
+
+    testsFailed += TestEraseState();
+
+#if defined(KECCAK_INSTRUMENTATION)
+    testsFailed += TestInstrumentation();
+#endif
+
     printf("%d Tests Failed\n", testsFailed);
 
-    return 0;
+    return testsFailed != 0;
 }